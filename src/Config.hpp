@@ -29,6 +29,97 @@
 // Power monitoring
 #define POWER_SENSE_PIN_NUM 32  // GPIO 32 (RTC GPIO) - HIGH = main power, LOW = battery
 
+// Power-fail detection: a falling edge on the power sense pin has to stay
+// LOW this long to count as a power failure; shorter dips are glitches.
+// The handler task has the display task blank the panel, then flushes
+// settings and sleeps. Blanking comes first and may use up to
+// POWER_FAIL_BLANK_WAIT_US; the settings commit only runs if it fits in
+// what is left of POWER_FAIL_BUDGET_US.
+#define POWER_FAIL_DEBOUNCE_US 2000
+#define POWER_FAIL_TASK_PRIORITY 10     // Above the web server and display
+#define POWER_FAIL_BUDGET_US 5000
+#define POWER_FAIL_BLANK_WAIT_US 2000   // A triggered display job, less than one period
+
+// ULP timekeeping: the RTC slow clock (~150 kHz RC) is measured against the
+// crystal briefly at boot, then over a long window every RTC_CAL_INTERVAL_S
+// while awake, and the ULP period is reprogrammed from the result
+#define RTC_CAL_BOOT_CYCLES 1000
+#define RTC_CAL_INTERVAL_S 600
+
+// Seconds the ULP adds per wake (1-60). The ULP only counts time; main
+// power coming back wakes the CPU through ext0 on the power sense pin.
+#define ULP_TICK_SECONDS 4
+
+// Deep-sleep current model behind the estimates in /api/time, from the
+// ESP32 datasheet: RTC timer and slow memory, and the ULP while it runs.
+// The ULP's time awake per wake is measured by calibration; until then
+// the host simulator's figure is used.
+#define SLEEP_BASE_CURRENT_NA 10000
+#define ULP_ACTIVE_CURRENT_UA 150
+#define ULP_AWAKE_ESTIMATE_US 18
+
+// Clock after a power-on reset, until synced: 2026-01-01 12:00:00 local
+#define TIME_DEFAULT_EPOCH 1767268800UL
+
+// Task model: 0 = one FreeRTOS task per job (display, storage, time, plus
+// the profiler and log drain tasks), 1 = one cooperative run loop per core;
+// frees the storage, profiler and log drain tasks' stacks
+#define LEDSTACK_EXECUTOR_MODE 0
+
+// Settings persistence: commit to NVS once no change has arrived for this long
+#define SETTINGS_QUIET_PERIOD_MS 3000
+#define SETTINGS_SAVE_ESTIMATE_US 2000  // Assumed commit time until one is measured
+
+// Request message pool: shared text storage and longest accepted header text
+#define MESSAGE_TEXT_ARENA_SIZE 1024
+#define MAX_HEADER_TEXT_LEN 512
+
+// Performance profiler: sampling period and number of samples kept
+#define PERF_SAMPLE_PERIOD_MS 1000
+#define PERF_HISTORY_LEN 8
+#define PERF_SERIAL_DUMP_EVERY 10  // Dump to serial every N samples (debug builds)
+
+// Latency trace ring (events, power of two)
+#define TRACE_RING_SIZE 128
+
+// System logger: ring size (records, power of two), arguments per record,
+// inline string bytes per record, and output format
+#define LOG_RING_SIZE 32
+#define LOG_MAX_ARGS 4
+#define LOG_STRING_BYTES 24
+#define LOG_OUTPUT_BINARY 0  // 1 = binary frames for offline decoding
+#define LOG_DRAIN_PERIOD_MS 20
+
+// HTTP server (esp_http_server task)
+#if LEDSTACK_EXECUTOR_MODE
+#define HTTP_SERVER_STACK_SIZE (8192 + 4096)  // StorageTask stack reclaimed by the shared core 1 loop
+#else
+#define HTTP_SERVER_STACK_SIZE 8192
+#endif
+#define HTTP_SERVER_PRIORITY 5
+#define HTTP_SERVER_CORE 0
+#define HTTP_MAX_OPEN_SOCKETS 7  // Bounded by LWIP_MAX_SOCKETS minus internal sockets
+#define HTTP_ARGS_BUFFER_SIZE (3 * MAX_HEADER_TEXT_LEN + 64)  // Fully percent-encoded header text
+#define STATE_APPLY_TIMEOUT_MS 250  // POST /api/state replies 202 if not applied within this
+#define STATE_LONG_POLL_MAX_S 30    // Longest GET /api/state?wait= hold
+#define STATE_MAX_WAITERS 4         // Concurrent long-polls and pending POSTs (each holds a socket)
+#define STATE_POLL_INTERVAL_MS 20   // How often long-polls and WebSocket clients are serviced
+#define WS_MAX_CLIENTS 3            // Concurrent /ws connections (each holds a socket)
+#define DISPLAY_SUBMIT_WAIT_MS 20   // Longest a handler waits for room in the display ring
+#define DISPLAY_RETRY_AFTER_S "1"   // Retry-After sent with 503 display busy
+
+// Time sync: NTP-style samples from the control page or a LAN SNTP server.
+// The lowest-delay of the last few samples is used; small offsets are
+// ignored, medium ones slewed and large ones stepped.
+#define TIME_SYNC_FILTER_SIZE 8       // Samples kept for the min-delay filter
+#define TIME_SYNC_MAX_DELAY_MS 500    // Round trips slower than this are discarded
+#define TIME_SYNC_DEADBAND_MS 20      // Offsets below this are left alone
+#define TIME_SYNC_STEP_MS 1000        // Offsets from here up are stepped, below slewed
+#define TIME_SYNC_SLEW_PPM 5000       // Slew rate (5 ms of correction per second)
+#define TIME_SYNC_SNTP_SERVER ""      // LAN SNTP server address; empty disables the client
+#define TIME_SYNC_SNTP_INTERVAL_S 64
+#define TIME_SYNC_UTC_OFFSET_S 0      // Local time zone, applied to SNTP (UTC) time only
+
 // WiFi AP configuration
 #define DEFAULT_AP_SSID "ledStack-AP"
 #define DEFAULT_AP_PASSWORD "12345678"
@@ -36,4 +127,19 @@
 // Web authentication
 #define WEB_USERNAME "ledStack"
 #define WEB_PASSWORD "generic"
-#define DEBUG_LEDSTACK
\ No newline at end of file
+#define SESSION_TOKEN_TTL_S 43200  // POST /api/login tokens last 12 hours (or until reboot)
+#define SESSION_MAX_REVOKED 8      // Logged-out tokens remembered until they expire
+#define DEBUG_LEDSTACK
+
+// Per-module log levels (LOG_LEVEL_NONE/ERROR/WARN/INFO/DEBUG); anything
+// above a module's level is compiled out. Other builds default to NONE:
+// no log call is left and the drain task is not started.
+#ifdef DEBUG_LEDSTACK
+#define LOG_LEVEL_DEFAULT LOG_LEVEL_DEBUG
+#else
+#define LOG_LEVEL_DEFAULT LOG_LEVEL_NONE
+#endif
+#define LOG_LEVEL_APP LOG_LEVEL_DEFAULT
+#define LOG_LEVEL_DISPLAY LOG_LEVEL_DEFAULT
+#define LOG_LEVEL_WEB LOG_LEVEL_DEFAULT
+#define LOG_LEVEL_STORAGE LOG_LEVEL_DEFAULT
@@ -1,5 +1,6 @@
 #pragma once
 #include <Arduino.h>
+#include "Config.hpp"
 
 enum PowerStatus {
     BATTERY_POWER = 0,  // GPIO LOW = battery
@@ -20,17 +21,76 @@ enum LED_PANEL_ACTION {
     SET_TIME_COL,
     SET_BG_COL,
     SET_LED_BRIGHT,
-    SET_TIME_DATA
+    SET_STATE       // Several fields at once (DisplayStatePatch)
 };
 
+// Result of handing a request to the display task
+enum SUBMIT_STATUS {
+    SUBMIT_OK,
+    SUBMIT_BUSY     // Display ring or message pool full; retry later
+};
+
+// Bit flags identifying individual display fields (coalescing and persistence).
+// New fields go last; CommandCoalescer::FIELD_COUNT is checked against the
+// highest one.
+enum DISPLAY_FIELD : uint8_t {
+    FIELD_BRIGHTNESS   = 1 << 0,
+    FIELD_HEADER_TEXT  = 1 << 1,
+    FIELD_HEADER_COLOR = 1 << 2,
+    FIELD_TIME_COLOR   = 1 << 3,
+    FIELD_BG_COLOR     = 1 << 4,
+    FIELD_TIME_TEXT    = 1 << 5
+};
+
+// Fields that are saved to NVS
+constexpr uint8_t FIELD_PERSISTENT_MASK =
+    FIELD_BRIGHTNESS | FIELD_HEADER_TEXT | FIELD_HEADER_COLOR | FIELD_TIME_COLOR | FIELD_BG_COLOR;
+
+// Any subset of the display settings, applied by the display task in one
+// update and persisted in one write-behind batch
+struct DisplayStatePatch {
+    const char* headerText;
+    uint32_t headerColor;
+    uint32_t timeColor;
+    uint32_t bgColor;
+    uint8_t brightness;
+    uint8_t fields;         // DISPLAY_FIELD mask of the members that are set
+    uint32_t ifMatch;       // Apply only at this state version; 0 = unconditional
+    uint32_t sequence;      // Submission number, echoed back in DisplayStateSnapshot
+};
+
+// Text payloads point into MessagePool storage (or caller-owned memory
+// before the request has been allocated into the pool)
 struct LED_PANEL_REQUEST {
     LED_PANEL_ACTION action = LED_P_OK;
     union {
-        char text[128];
+        const char* text;
         uint32_t color;
         uint8_t brightness;
-        TimeData timeData;
+        DisplayStatePatch state;
     } data;
+    uint16_t traceId = 0;   // LatencyTrace id, 0 if the request is not traced
+};
+
+// Clock state published by the time task (any core) and applied to LVGL
+// by the display task only
+struct ClockDisplayState {
+    char timeText[16];
+};
+
+// Current display settings, published by the display task after every
+// applied change. `version` starts at a random nonzero value each boot,
+// increases with each change and is the ETag of /api/state; the sequence
+// numbers report the outcome of SET_STATE requests.
+struct DisplayStateSnapshot {
+    uint32_t version;
+    uint32_t appliedSequence;   // Last SET_STATE processed (applied or rejected)
+    uint32_t rejectedMask;      // Bit i: SET_STATE appliedSequence - i was rejected by its If-Match version
+    uint32_t headerColor;
+    uint32_t timeColor;
+    uint32_t bgColor;
+    uint8_t brightness;
+    char headerText[MAX_HEADER_TEXT_LEN + 1];
 };
 
 struct DisplaySettings {
@@ -38,5 +98,5 @@ struct DisplaySettings {
     uint32_t headerColor;
     uint32_t timeColor;
     uint32_t bgColor;
-    char headerText[128];
+    char headerText[MAX_HEADER_TEXT_LEN + 1];
 };
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "Calendar.hpp"
+
+// Eras are 400-year cycles starting on 0000-03-01, so the leap day ends
+// the year and month lengths follow a fixed 153-day five-month pattern
+
+int32_t Calendar::daysFromCivil(int32_t year, uint32_t month, uint32_t day) {
+    year -= month <= 2;
+    int32_t era = (year >= 0 ? year : year - 399) / 400;
+    uint32_t yearOfEra = (uint32_t)(year - era * 400);                              // [0, 399]
+    uint32_t dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1; // [0, 365]
+    uint32_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;  // [0, 146096]
+    return era * 146097 + (int32_t)dayOfEra - 719468;
+}
+
+void Calendar::civilFromDays(int32_t days, int32_t& year, uint32_t& month, uint32_t& day) {
+    days += 719468;
+    int32_t era = (days >= 0 ? days : days - 146096) / 146097;
+    uint32_t dayOfEra = (uint32_t)(days - era * 146097);                                   // [0, 146096]
+    uint32_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365; // [0, 399]
+    uint32_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);   // [0, 365]
+    uint32_t monthIndex = (5 * dayOfYear + 2) / 153;                                     // [0, 11] from March
+    day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+    year = (int32_t)yearOfEra + era * 400 + (month <= 2);
+}
+
+Calendar::DateTime Calendar::fromEpoch(uint32_t epochSeconds) {
+    uint32_t days = epochSeconds / 86400;
+    uint32_t seconds = epochSeconds % 86400;
+
+    int32_t year;
+    uint32_t month, day;
+    civilFromDays(days, year, month, day);
+
+    DateTime result;
+    result.year = year;
+    result.month = month;
+    result.day = day;
+    result.weekday = (days + 4) % 7;    // 1970-01-01 was a Thursday
+    result.hour = seconds / 3600;
+    result.minute = (seconds / 60) % 60;
+    result.second = seconds % 60;
+    return result;
+}
+
+uint32_t Calendar::toEpoch(const DateTime& dateTime) {
+    return (uint32_t)daysFromCivil(dateTime.year, dateTime.month, dateTime.day) * 86400 +
+           dateTime.hour * 3600 + dateTime.minute * 60 + dateTime.second;
+}
+
+bool Calendar::isValid(const DateTime& dateTime) {
+    if (dateTime.year < 1970 || dateTime.year > 2105 || dateTime.month < 1 || dateTime.month > 12 ||
+        dateTime.day < 1 || dateTime.hour > 23 || dateTime.minute > 59 || dateTime.second > 59) {
+        return false;
+    }
+    // The day exists if it survives a round trip
+    int32_t year;
+    uint32_t month, day;
+    civilFromDays(daysFromCivil(dateTime.year, dateTime.month, dateTime.day), year, month, day);
+    return month == dateTime.month && day == dateTime.day;
+}
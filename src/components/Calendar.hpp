@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdint.h>
+
+// Proleptic Gregorian calendar over seconds since 1970-01-01 (local time;
+// no time zone or leap second handling). Plain integer arithmetic with no
+// tables or loops, after Howard Hinnant's days_from_civil/civil_from_days.
+// Shared with the host ULP simulator, so no Arduino headers here.
+class Calendar {
+public:
+    struct DateTime {
+        uint16_t year;
+        uint8_t month;      // 1-12
+        uint8_t day;        // 1-31
+        uint8_t weekday;    // 0 = Sunday
+        uint8_t hour;
+        uint8_t minute;
+        uint8_t second;
+    };
+
+    static DateTime fromEpoch(uint32_t epochSeconds);
+    static uint32_t toEpoch(const DateTime& dateTime);
+
+    // Day count from 1970-01-01 to a date and back
+    static int32_t daysFromCivil(int32_t year, uint32_t month, uint32_t day);
+    static void civilFromDays(int32_t days, int32_t& year, uint32_t& month, uint32_t& day);
+
+    // True if the fields name a real date and time (years 1970-2105)
+    static bool isValid(const DateTime& dateTime);
+};
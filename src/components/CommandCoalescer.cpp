@@ -0,0 +1,56 @@
+#include "CommandCoalescer.hpp"
+
+void CommandCoalescer::init(MessagePool* pool) {
+    this->pool = pool;
+    dirtyFields = 0;
+    receivedCount = 0;
+    coalescedCount = 0;
+}
+
+void CommandCoalescer::merge(MessageHandle handle) {
+    DISPLAY_FIELD field = fieldForAction(pool->get(handle).action);
+    if (field == 0) {
+        pool->release(handle);
+        return;
+    }
+
+    receivedCount++;
+
+    // An earlier request for the same field is overwritten and never applied
+    if (dirtyFields & field) {
+        pool->release(pending[fieldIndex(field)]);
+        coalescedCount++;
+    }
+
+    pending[fieldIndex(field)] = handle;
+    dirtyFields |= field;
+}
+
+MessageHandle CommandCoalescer::getPending(DISPLAY_FIELD field) const {
+    return pending[fieldIndex(field)];
+}
+
+void CommandCoalescer::clear() {
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+        if (dirtyFields & (1 << i)) {
+            pool->release(pending[i]);
+        }
+    }
+    dirtyFields = 0;
+}
+
+DISPLAY_FIELD CommandCoalescer::fieldForAction(LED_PANEL_ACTION action) {
+    switch (action) {
+        case SET_HEADER_T:   return FIELD_HEADER_TEXT;
+        case SET_HEADER_COL: return FIELD_HEADER_COLOR;
+        case SET_TIME_T:     return FIELD_TIME_TEXT;
+        case SET_TIME_COL:   return FIELD_TIME_COLOR;
+        case SET_BG_COL:     return FIELD_BG_COLOR;
+        case SET_LED_BRIGHT: return FIELD_BRIGHTNESS;
+        default:             return (DISPLAY_FIELD)0;
+    }
+}
+
+size_t CommandCoalescer::fieldIndex(DISPLAY_FIELD field) {
+    return __builtin_ctz(field);
+}
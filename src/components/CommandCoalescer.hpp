@@ -0,0 +1,45 @@
+#pragma once
+
+#include "MessagePool.hpp"
+#include "../Types.hpp"
+
+// Collapses a burst of display requests into one update per field.
+// The display task drains its queue into the coalescer each cycle and then
+// applies the surviving requests once (last writer wins per field).
+// The coalescer owns one pool reference per pending handle.
+class CommandCoalescer {
+public:
+    void init(MessagePool* pool);
+
+    // Merge a request into the pending update, taking over the caller's reference
+    void merge(MessageHandle handle);
+
+    // Pending update access
+    bool hasPending() const { return dirtyFields != 0; }
+    uint8_t getDirtyFields() const { return dirtyFields; }
+    MessageHandle getPending(DISPLAY_FIELD field) const;
+
+    // Drop the pending update, releasing the coalescer's references
+    void clear();
+
+    // Statistics
+    uint32_t getReceivedCount() const { return receivedCount; }
+    uint32_t getCoalescedCount() const { return coalescedCount; }
+
+    static DISPLAY_FIELD fieldForAction(LED_PANEL_ACTION action);
+
+    // One pending slot per DISPLAY_FIELD bit
+    static constexpr size_t FIELD_COUNT = 6;
+    static_assert((1u << (FIELD_COUNT - 1)) == FIELD_TIME_TEXT,
+                  "FIELD_COUNT must reach the highest DISPLAY_FIELD bit");
+
+private:
+    static size_t fieldIndex(DISPLAY_FIELD field);
+
+    MessagePool* pool;
+    MessageHandle pending[FIELD_COUNT];
+    uint8_t dirtyFields;
+
+    uint32_t receivedCount;   // Requests merged since boot
+    uint32_t coalescedCount;  // Requests superseded before being applied
+};
@@ -1,4 +1,5 @@
 #include "DisplayManager.hpp"
+#include "SystemLogger.hpp"
 #include "ui/ui.h"
 #include "ui/screens.h"
 
@@ -13,6 +14,10 @@ void DisplayManager::init() {
     lvDisplay = nullptr;
     lvBuffer1 = nullptr;
     lvBuffer2 = nullptr;
+    latencyTrace = nullptr;
+    pendingTraceCount = 0;
+    blankRequested = false;
+    blanked = false;
 
     initHardwareDisplay();
     initLVGL();
@@ -51,7 +56,7 @@ void DisplayManager::initHardwareDisplay() {
     virtualDisplay->clearScreen();
     virtualDisplay->invertDisplay(true);
 
-    Serial.println("Display hardware initialized");
+    LOG_I(DISPLAY, "Display hardware initialized");
 }
 
 void DisplayManager::initLVGL() {
@@ -75,13 +80,13 @@ void DisplayManager::initLVGL() {
     lv_display_set_buffers(lvDisplay, lvBuffer1, lvBuffer2, buf_bytes, LV_DISPLAY_RENDER_MODE_PARTIAL);
     lv_display_set_flush_cb(lvDisplay, lvglFlushCallback);
 
-    Serial.println("LVGL initialized");
+    LOG_I(DISPLAY, "LVGL initialized");
 }
 
 void DisplayManager::initUI() {
     ui_init();
     ui_tick();
-    Serial.println("UI initialized");
+    LOG_I(DISPLAY, "UI initialized");
 }
 
 void DisplayManager::update() {
@@ -94,22 +99,22 @@ void DisplayManager::lvglTick() {
 }
 
 void DisplayManager::setHeaderText(const char* message) {
-    Serial.printf("DisplayManager: setHeaderText('%s')\n", message);
+    LOG_D(DISPLAY, "DisplayManager: setHeaderText('%s')", message);
     if (objects.head_lb__main_ctn) {
         lv_label_set_text(objects.head_lb__main_ctn, message);
-        Serial.println("Header text updated");
+        LOG_D(DISPLAY, "Header text updated");
     } else {
-        Serial.println("ERROR: objects.head_lb__main_ctn is NULL");
+        LOG_E(DISPLAY, "ERROR: objects.head_lb__main_ctn is NULL");
     }
 }
 
 void DisplayManager::setHeaderColor(uint32_t color) {
-    Serial.printf("DisplayManager: setHeaderColor(0x%06X)\n", color);
+    LOG_D(DISPLAY, "DisplayManager: setHeaderColor(0x%06X)", color);
     if (objects.head_lb__main_ctn) {
         lv_obj_set_style_text_color(objects.head_lb__main_ctn, lv_color_hex(color), LV_PART_MAIN | LV_STATE_DEFAULT);
-        Serial.println("Header color updated");
+        LOG_D(DISPLAY, "Header color updated");
     } else {
-        Serial.println("ERROR: objects.head_lb__main_ctn is NULL");
+        LOG_E(DISPLAY, "ERROR: objects.head_lb__main_ctn is NULL");
     }
 }
 
@@ -117,41 +122,57 @@ void DisplayManager::setTimeText(const char* message) {
     if (objects.time_lb__main_ctn) {
         lv_label_set_text(objects.time_lb__main_ctn, message);
     } else {
-        Serial.println("ERROR: objects.time_lb__main_ctn is NULL");
+        LOG_E(DISPLAY, "ERROR: objects.time_lb__main_ctn is NULL");
     }
 }
 
 void DisplayManager::setTimeColor(uint32_t color) {
-    Serial.printf("DisplayManager: setTimeColor(0x%06X)\n", color);
+    LOG_D(DISPLAY, "DisplayManager: setTimeColor(0x%06X)", color);
     if (objects.time_lb__main_ctn) {
         lv_obj_set_style_text_color(objects.time_lb__main_ctn, lv_color_hex(color), LV_PART_MAIN | LV_STATE_DEFAULT);
-        Serial.println("Time color updated");
+        LOG_D(DISPLAY, "Time color updated");
     } else {
-        Serial.println("ERROR: objects.time_lb__main_ctn is NULL");
+        LOG_E(DISPLAY, "ERROR: objects.time_lb__main_ctn is NULL");
     }
 }
 
 void DisplayManager::setBackgroundColor(uint32_t color) {
-    Serial.printf("DisplayManager: setBackgroundColor(0x%06X)\n", color);
+    LOG_D(DISPLAY, "DisplayManager: setBackgroundColor(0x%06X)", color);
     if (objects.main_ctn) {
         lv_obj_set_style_bg_color(objects.main_ctn, lv_color_hex(color), LV_PART_MAIN | LV_STATE_DEFAULT);
-        Serial.println("Background color updated");
+        LOG_D(DISPLAY, "Background color updated");
     } else {
-        Serial.println("ERROR: objects.main_ctn is NULL");
+        LOG_E(DISPLAY, "ERROR: objects.main_ctn is NULL");
     }
 }
 
 void DisplayManager::setBrightness(uint8_t brightness) {
-    Serial.printf("DisplayManager: setBrightness(%d)\n", brightness);
+    LOG_D(DISPLAY, "DisplayManager: setBrightness(%d)", brightness);
     if (dmaDisplay) {
         dmaDisplay->setBrightness(brightness);
-        Serial.println("Brightness updated");
+        LOG_D(DISPLAY, "Brightness updated");
     } else {
-        Serial.println("ERROR: dmaDisplay is NULL");
+        LOG_E(DISPLAY, "ERROR: dmaDisplay is NULL");
     }
 }
 
-void DisplayManager::handleRequest(LED_PANEL_REQUEST request) {
+void DisplayManager::requestBlank() {
+    blankRequested = true;
+}
+
+bool DisplayManager::blankIfRequested() {
+    if (!blankRequested) return false;
+
+    if (!blanked) {
+        if (dmaDisplay) {
+            dmaDisplay->setBrightness(0);
+        }
+        blanked = true;
+    }
+    return true;
+}
+
+void DisplayManager::handleRequest(const LED_PANEL_REQUEST& request) {
     switch (request.action) {
         case SET_HEADER_T:
             setHeaderText(request.data.text);
@@ -171,11 +192,33 @@ void DisplayManager::handleRequest(LED_PANEL_REQUEST request) {
         case SET_LED_BRIGHT:
             setBrightness(request.data.brightness);
             break;
+        case SET_STATE: {
+            const DisplayStatePatch& state = request.data.state;
+            if (state.fields & FIELD_HEADER_TEXT)  setHeaderText(state.headerText);
+            if (state.fields & FIELD_HEADER_COLOR) setHeaderColor(state.headerColor);
+            if (state.fields & FIELD_TIME_COLOR)   setTimeColor(state.timeColor);
+            if (state.fields & FIELD_BG_COLOR)     setBackgroundColor(state.bgColor);
+            if (state.fields & FIELD_BRIGHTNESS)   setBrightness(state.brightness);
+            break;
+        }
         default:
             break;
     }
 }
 
+void DisplayManager::setLatencyTrace(LatencyTrace* trace) {
+    latencyTrace = trace;
+}
+
+void DisplayManager::traceNextFlush(uint16_t traceId) {
+    if (!latencyTrace || traceId == 0) return;
+    if (pendingTraceCount < MAX_PENDING_TRACES) {
+        pendingTraces[pendingTraceCount++] = traceId;
+    } else {
+        latencyTrace->record(traceId, TRACE_DROPPED);
+    }
+}
+
 // Static callback implementations
 uint32_t DisplayManager::lvglTickCallback() {
     return esp_timer_get_time() / 1000ULL;
@@ -191,5 +234,13 @@ void DisplayManager::lvglFlushCallback(lv_display_t* display, const lv_area_t* a
 
     instance->virtualDisplay->drawRGBBitmap(x, y, (uint16_t*)px_map, w, h);
 
+    // The frame is on the panel once its last area has been drawn
+    if (instance->pendingTraceCount && lv_display_flush_is_last(display)) {
+        for (size_t i = 0; i < instance->pendingTraceCount; i++) {
+            instance->latencyTrace->record(instance->pendingTraces[i], TRACE_FLUSHED);
+        }
+        instance->pendingTraceCount = 0;
+    }
+
     lv_display_flush_ready(instance->lvDisplay);
 }
@@ -7,6 +7,7 @@
 #include <lvgl.h>
 #include "../Config.hpp"
 #include "../Types.hpp"
+#include "LatencyTrace.hpp"
 
 // Forward declarations for EEZ UI
 extern "C" void ui_init();
@@ -25,12 +26,23 @@ public:
     void setBackgroundColor(uint32_t color);
     void setBrightness(uint8_t brightness);
 
+    // Power failure: requestBlank() (any task) asks the display task to
+    // turn the panel off; blankIfRequested() (display task, before any
+    // drawing) does so and from then on returns true so nothing is drawn
+    void requestBlank();
+    bool blankIfRequested();
+    bool isBlanked() const { return blanked; }
+
     // Request handler
-    void handleRequest(LED_PANEL_REQUEST request);
+    void handleRequest(const LED_PANEL_REQUEST& request);
 
     // LVGL tick for task scheduling
     void lvglTick();
 
+    // Latency tracing: record TRACE_FLUSHED for `traceId` when the next frame is flushed
+    void setLatencyTrace(LatencyTrace* trace);
+    void traceNextFlush(uint16_t traceId);
+
 private:
     // Hardware display objects
     MatrixPanel_I2S_DMA* dmaDisplay;
@@ -55,6 +67,15 @@ private:
     static uint32_t lvglTickCallback();
     static void lvglFlushCallback(lv_display_t* display, const lv_area_t* area, uint8_t* px_map);
 
+    // Traces waiting for the end of the next flush
+    static constexpr size_t MAX_PENDING_TRACES = 4;
+    LatencyTrace* latencyTrace;
+    uint16_t pendingTraces[MAX_PENDING_TRACES];
+    size_t pendingTraceCount;
+
+    volatile bool blankRequested;
+    volatile bool blanked;
+
     // Static instance for callbacks
     static DisplayManager* instance;
 };
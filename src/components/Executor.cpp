@@ -0,0 +1,113 @@
+#include "Executor.hpp"
+#include <esp_timer.h>
+
+void Executor::init(const char* name) {
+    this->name = name;
+    jobCount = 0;
+    taskHandle = nullptr;
+}
+
+int Executor::addJob(const char* name, JobFunction run, uint32_t periodMs) {
+    if (jobCount >= MAX_JOBS) return -1;
+
+    Job& job = jobs[jobCount];
+    job.name = name;
+    job.run = run;
+    job.periodUs = periodMs * 1000;
+    job.deadlineUs = 0;
+    job.triggered = false;
+    job.runs = 0;
+    job.maxLatenessUs = 0;
+    job.totalLatenessUs = 0;
+    job.maxRunUs = 0;
+
+    return jobCount++;
+}
+
+bool Executor::start(uint32_t stackSize, UBaseType_t priority, BaseType_t core) {
+    int64_t now = esp_timer_get_time();
+    for (size_t i = 0; i < jobCount; i++) {
+        jobs[i].deadlineUs = now;
+    }
+
+    return xTaskCreatePinnedToCore(
+        executorTask,
+        name,
+        stackSize,
+        this,
+        priority,
+        &taskHandle,
+        core
+    ) == pdPASS;
+}
+
+void Executor::trigger(int job) {
+    if (job < 0 || (size_t)job >= jobCount) return;
+
+    jobs[job].triggered = true;
+    if (taskHandle) {
+        xTaskNotifyGive(taskHandle);
+    }
+}
+
+Executor::JobStats Executor::getJobStats(size_t index) const {
+    const Job& job = jobs[index];
+    JobStats stats;
+    stats.name = job.name;
+    stats.runs = job.runs;
+    stats.maxLatenessUs = job.maxLatenessUs;
+    stats.avgLatenessUs = job.runs ? job.totalLatenessUs / job.runs : 0;
+    stats.maxRunUs = job.maxRunUs;
+    return stats;
+}
+
+void Executor::runLoop() {
+    while (true) {
+        int64_t now = esp_timer_get_time();
+        int64_t nextDeadline = INT64_MAX;
+
+        for (size_t i = 0; i < jobCount; i++) {
+            Job& job = jobs[i];
+
+            if (job.triggered) {
+                // Triggered work is due immediately and does not count as late
+                job.triggered = false;
+                job.deadlineUs = now;
+            }
+
+            if (now >= job.deadlineUs) {
+                uint32_t lateness = now - job.deadlineUs;
+                job.run();
+                int64_t finished = esp_timer_get_time();
+
+                uint32_t runTime = finished - now;
+                job.runs++;
+                job.totalLatenessUs += lateness;
+                if (lateness > job.maxLatenessUs) job.maxLatenessUs = lateness;
+                if (runTime > job.maxRunUs) job.maxRunUs = runTime;
+
+                // Fixed-rate schedule; skip missed periods instead of bursting
+                job.deadlineUs += job.periodUs;
+                if (job.deadlineUs <= finished) {
+                    job.deadlineUs = finished + job.periodUs;
+                }
+                now = finished;
+            }
+
+            if (job.deadlineUs < nextDeadline) {
+                nextDeadline = job.deadlineUs;
+            }
+        }
+
+        // Sleep until the earliest deadline or until trigger() rings
+        int64_t waitUs = nextDeadline - esp_timer_get_time();
+        if (waitUs > 0) {
+            TickType_t ticks = pdMS_TO_TICKS((waitUs + 999) / 1000);
+            ulTaskNotifyTake(pdTRUE, ticks ? ticks : 1);
+        }
+    }
+}
+
+void Executor::executorTask(void* parameter) {
+    static_cast<Executor*>(parameter)->runLoop();
+}
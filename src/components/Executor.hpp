@@ -0,0 +1,64 @@
+#pragma once
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Cooperative run loop executing periodic jobs on one FreeRTOS task.
+// Each job has a period; its next deadline is the previous deadline plus
+// the period, and the loop sleeps until the earliest deadline or until
+// trigger() makes a job due immediately. Jobs must not block.
+//
+// The firmware uses one executor per job in task mode and one executor
+// per core in executor mode (LEDSTACK_EXECUTOR_MODE), so job latency is
+// measured the same way in both.
+class Executor {
+public:
+    typedef void (*JobFunction)();
+
+    struct JobStats {
+        const char* name;
+        uint32_t runs;
+        uint32_t maxLatenessUs;   // Worst start time after the deadline
+        uint32_t avgLatenessUs;
+        uint32_t maxRunUs;        // Worst execution time
+    };
+
+    void init(const char* name);
+
+    // Register a job before start(); returns its index or -1 if full
+    int addJob(const char* name, JobFunction run, uint32_t periodMs);
+
+    // Create the run-loop task
+    bool start(uint32_t stackSize, UBaseType_t priority, BaseType_t core);
+
+    // Make a job due now and wake the loop (safe from other tasks)
+    void trigger(int job);
+
+    size_t getJobCount() const { return jobCount; }
+    JobStats getJobStats(size_t job) const;
+    TaskHandle_t getTaskHandle() const { return taskHandle; }
+
+    static constexpr size_t MAX_JOBS = 4;
+
+private:
+    struct Job {
+        const char* name;
+        JobFunction run;
+        uint32_t periodUs;
+        int64_t deadlineUs;
+        volatile bool triggered;
+
+        uint32_t runs;
+        uint32_t maxLatenessUs;
+        uint64_t totalLatenessUs;
+        uint32_t maxRunUs;
+    };
+
+    const char* name;
+    Job jobs[MAX_JOBS];
+    size_t jobCount;
+    TaskHandle_t taskHandle;
+
+    void runLoop();
+    static void executorTask(void* parameter);
+};
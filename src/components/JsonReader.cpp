@@ -0,0 +1,179 @@
+#include "JsonReader.hpp"
+#include <stdlib.h>
+#include <string.h>
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool readHex4(const char* in, uint32_t& out) {
+    out = 0;
+    for (int i = 0; i < 4; i++) {
+        int digit = hexValue(in[i]);
+        if (digit < 0) return false;
+        out = (out << 4) | digit;
+    }
+    return true;
+}
+
+bool JsonReader::begin(char* json) {
+    cursor = json;
+    error = false;
+    done = false;
+    first = true;
+
+    skipWhitespace();
+    if (*cursor != '{') return fail();
+    cursor++;
+    return true;
+}
+
+bool JsonReader::next(JsonField& field) {
+    if (error || done) return false;
+
+    skipWhitespace();
+    if (*cursor == '}') {
+        cursor++;
+        skipWhitespace();
+        done = true;
+        if (*cursor != '\0') fail();  // Trailing garbage
+        return false;
+    }
+
+    if (!first) {
+        if (*cursor != ',') return fail();
+        cursor++;
+        skipWhitespace();
+    }
+    first = false;
+
+    if (*cursor != '"' || !parseString(field.key)) return fail();
+
+    skipWhitespace();
+    if (*cursor != ':') return fail();
+    cursor++;
+    skipWhitespace();
+
+    field.string = nullptr;
+    field.number = 0;
+    field.boolean = false;
+
+    switch (*cursor) {
+        case '"':
+            field.type = JSON_STRING;
+            return parseString(field.string) || fail();
+        case 't':
+            field.type = JSON_BOOL;
+            field.boolean = true;
+            return parseLiteral("true") || fail();
+        case 'f':
+            field.type = JSON_BOOL;
+            return parseLiteral("false") || fail();
+        case 'n':
+            field.type = JSON_NULL;
+            return parseLiteral("null") || fail();
+        default:
+            field.type = JSON_NUMBER;
+            return parseNumber(field.number) || fail();
+    }
+}
+
+void JsonReader::skipWhitespace() {
+    while (*cursor == ' ' || *cursor == '\t' || *cursor == '\r' || *cursor == '\n') {
+        cursor++;
+    }
+}
+
+bool JsonReader::fail() {
+    error = true;
+    return false;
+}
+
+bool JsonReader::parseString(const char*& out) {
+    // Unescaped output never outruns the input, so decode in place
+    char* in = cursor + 1;
+    char* write = in;
+    out = write;
+
+    while (*in != '"') {
+        char c = *in++;
+        if (c == '\0' || (unsigned char)c < 0x20) return false;
+        if (c != '\\') {
+            *write++ = c;
+            continue;
+        }
+
+        c = *in++;
+        switch (c) {
+            case '"':  *write++ = '"';  break;
+            case '\\': *write++ = '\\'; break;
+            case '/':  *write++ = '/';  break;
+            case 'b':  *write++ = '\b'; break;
+            case 'f':  *write++ = '\f'; break;
+            case 'n':  *write++ = '\n'; break;
+            case 'r':  *write++ = '\r'; break;
+            case 't':  *write++ = '\t'; break;
+            case 'u': {
+                uint32_t code;
+                if (!readHex4(in, code)) return false;
+                in += 4;
+
+                // Surrogate pair
+                if (code >= 0xD800 && code <= 0xDBFF) {
+                    uint32_t low;
+                    if (in[0] != '\\' || in[1] != 'u' || !readHex4(in + 2, low) ||
+                        low < 0xDC00 || low > 0xDFFF) {
+                        return false;
+                    }
+                    in += 6;
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                } else if (code >= 0xDC00 && code <= 0xDFFF) {
+                    return false;
+                }
+
+                // UTF-8 encode (at most 4 bytes for 6 or 12 bytes of input)
+                if (code < 0x80) {
+                    *write++ = code;
+                } else if (code < 0x800) {
+                    *write++ = 0xC0 | (code >> 6);
+                    *write++ = 0x80 | (code & 0x3F);
+                } else if (code < 0x10000) {
+                    *write++ = 0xE0 | (code >> 12);
+                    *write++ = 0x80 | ((code >> 6) & 0x3F);
+                    *write++ = 0x80 | (code & 0x3F);
+                } else {
+                    *write++ = 0xF0 | (code >> 18);
+                    *write++ = 0x80 | ((code >> 12) & 0x3F);
+                    *write++ = 0x80 | ((code >> 6) & 0x3F);
+                    *write++ = 0x80 | (code & 0x3F);
+                }
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+
+    *write = '\0';
+    cursor = in + 1;
+    return true;
+}
+
+bool JsonReader::parseNumber(long& out) {
+    char* end;
+    if (*cursor != '-' && (*cursor < '0' || *cursor > '9')) return false;
+    out = strtol(cursor, &end, 10);
+    if (end == cursor || *end == '.' || *end == 'e' || *end == 'E') return false;
+    cursor = end;
+    return true;
+}
+
+bool JsonReader::parseLiteral(const char* literal) {
+    size_t length = strlen(literal);
+    if (strncmp(cursor, literal, length) != 0) return false;
+    cursor += length;
+    return true;
+}
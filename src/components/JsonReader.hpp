@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum JSON_TYPE {
+    JSON_STRING,
+    JSON_NUMBER,    // Integers only
+    JSON_BOOL,
+    JSON_NULL
+};
+
+struct JsonField {
+    const char* key;
+    JSON_TYPE type;
+    const char* string;  // JSON_STRING
+    long number;         // JSON_NUMBER
+    bool boolean;        // JSON_BOOL
+};
+
+// Minimal reader for one flat JSON object such as the /api/state body.
+// Parsing is in place: keys and string values are unescaped into the input
+// buffer and returned as pointers into it, so nothing is allocated. Nested
+// objects/arrays and fractional numbers are rejected as errors.
+class JsonReader {
+public:
+    // `json` must be writable and NUL-terminated; it is modified
+    bool begin(char* json);
+
+    // Fetch the next member; false at the end of the object or on error
+    bool next(JsonField& field);
+
+    bool hasError() const { return error; }
+
+private:
+    char* cursor;
+    bool error;
+    bool done;
+    bool first;
+
+    void skipWhitespace();
+    bool fail();
+    bool parseString(const char*& out);
+    bool parseNumber(long& out);
+    bool parseLiteral(const char* literal);
+};
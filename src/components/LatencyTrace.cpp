@@ -0,0 +1,107 @@
+#include "LatencyTrace.hpp"
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <stdio.h>
+#include <string.h>
+
+void LatencyTrace::init() {
+    for (size_t i = 0; i < TRACE_RING_SIZE; i++) {
+        events[i].sequence.store(0, std::memory_order_relaxed);
+    }
+    writeIndex.store(0, std::memory_order_relaxed);
+    nextTraceId.store(1, std::memory_order_relaxed);
+}
+
+uint16_t LatencyTrace::begin() {
+    uint16_t traceId = nextTraceId.fetch_add(1, std::memory_order_relaxed);
+    if (traceId == 0) {
+        traceId = nextTraceId.fetch_add(1, std::memory_order_relaxed);
+    }
+    record(traceId, TRACE_HTTP_RECEIVED);
+    return traceId;
+}
+
+void LatencyTrace::record(uint16_t traceId, TRACE_STAGE stage) {
+    if (traceId == 0) return;
+
+    uint32_t index = writeIndex.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = events[index & (TRACE_RING_SIZE - 1)];
+
+    // The export may be reading this slot on the other core: mark it
+    // invalid before the fields change
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.timestampUs.store((uint32_t)esp_timer_get_time(), std::memory_order_relaxed);
+    slot.info.store(traceId | (uint32_t)stage << 16 | (uint32_t)xPortGetCoreID() << 24,
+                    std::memory_order_relaxed);
+    slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+bool LatencyTrace::readEvent(uint32_t index, Event& out) const {
+    const Slot& slot = events[index & (TRACE_RING_SIZE - 1)];
+
+    if (slot.sequence.load(std::memory_order_acquire) != index + 1) return false;
+    uint32_t timestampUs = slot.timestampUs.load(std::memory_order_relaxed);
+    uint32_t info = slot.info.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    // Discard the copy if a writer reused the slot meanwhile
+    if (slot.sequence.load(std::memory_order_relaxed) != index + 1) return false;
+
+    out.timestampUs = timestampUs;
+    out.traceId = info & 0xFFFF;
+    out.stage = (info >> 16) & 0xFF;
+    out.core = info >> 24;
+    return true;
+}
+
+size_t LatencyTrace::writeChromeJson(char* buffer, size_t size, uint32_t& cursor) {
+    static const char* const STAGE_NAMES[] = { "http", "dequeue", "invalidate", "flush", "dropped" };
+    // Async begin / step / step / end so each request shows up as one span
+    static const char* const STAGE_PHASES[] = { "b", "n", "n", "e", "e" };
+
+    // cursor: 0 = nothing written yet, UINT32_MAX = done, otherwise
+    // 1 + absolute index of the next event to write
+    if (cursor == UINT32_MAX || size == 0) return 0;
+
+    const uint32_t end = writeIndex.load(std::memory_order_acquire);
+    const uint32_t oldest = end > TRACE_RING_SIZE ? end - TRACE_RING_SIZE : 0;
+
+    size_t used = 0;
+    if (cursor == 0) {
+        used += snprintf(buffer, size,
+                         "{\"displayTimeUnit\":\"ms\",\"traceEvents\":["
+                         "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"ledStack\"}}");
+        cursor = oldest + 1;
+    }
+
+    while (cursor - 1 < end) {
+        uint32_t index = cursor - 1;
+
+        // Skip events overwritten since the previous call
+        Event event;
+        if (index < oldest || !readEvent(index, event)) {
+            cursor++;
+            continue;
+        }
+
+        char line[160];
+        int n = snprintf(line, sizeof(line),
+                         ",{\"name\":\"request\",\"cat\":\"latency\",\"ph\":\"%s\",\"id\":%u,"
+                         "\"ts\":%u,\"pid\":1,\"tid\":%u,\"args\":{\"stage\":\"%s\"}}",
+                         STAGE_PHASES[event.stage], event.traceId,
+                         event.timestampUs, event.core, STAGE_NAMES[event.stage]);
+        if (used + n >= size) return used;  // Continue from this event next call
+
+        memcpy(buffer + used, line, n + 1);
+        used += n;
+        cursor++;
+    }
+
+    if (used + 3 > size) return used;
+    used += snprintf(buffer + used, size - used, "]}");
+    cursor = UINT32_MAX;
+
+    return used;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <stddef.h>
+#include "../Config.hpp"
+
+// Stages a traced request passes through on its way to the panel
+enum TRACE_STAGE : uint8_t {
+    TRACE_HTTP_RECEIVED,   // Request authenticated and validated
+    TRACE_DEQUEUED,        // Popped from the display ring by displayTask
+    TRACE_INVALIDATED,     // LVGL object changed and invalidated
+    TRACE_FLUSHED,         // Last flush of the resulting frame finished
+    TRACE_DROPPED          // Never reached the display ring (merged or rejected)
+};
+
+// Lightweight end-to-end latency tracer.
+// Any task or core may record events; they go into a fixed lock-free ring
+// (oldest events are overwritten) and can be exported as Chrome
+// trace-event JSON for chrome://tracing or Perfetto. Every trace begun
+// ends with TRACE_FLUSHED or TRACE_DROPPED.
+//
+// Each slot is a small seqlock: the writer clears its sequence, fences,
+// stores the fields and publishes the sequence with release; the reader
+// loads the fields between an acquire load and an acquire fence and keeps
+// the copy only if the sequence did not change. All fields are relaxed
+// atomics so a reader racing a writer on another core is well defined.
+//
+// Timestamps come from the shared esp_timer clock rather than CCOUNT: the
+// ESP32 cycle counters are per core and not synchronised, and this trace
+// spans both cores.
+class LatencyTrace {
+public:
+    void init();
+
+    // Start a new trace and record TRACE_HTTP_RECEIVED; returns its id
+    // (never 0). Call once the request is known to be accepted.
+    uint16_t begin();
+
+    // Record a stage for an existing trace; id 0 is ignored
+    void record(uint16_t traceId, TRACE_STAGE stage);
+
+    // Write events starting at `cursor` (0 for the first call) as Chrome
+    // trace-event JSON. Returns bytes written; 0 once everything is written.
+    size_t writeChromeJson(char* buffer, size_t size, uint32_t& cursor);
+
+private:
+    static_assert((TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) == 0, "trace ring size must be a power of two");
+
+    struct Slot {
+        std::atomic<uint32_t> sequence;  // Index + 1 once written; 0 while being written
+        std::atomic<uint32_t> timestampUs;
+        std::atomic<uint32_t> info;      // traceId | stage << 16 | core << 24
+    };
+
+    struct Event {
+        uint32_t timestampUs;
+        uint16_t traceId;
+        uint8_t stage;
+        uint8_t core;
+    };
+
+    Slot events[TRACE_RING_SIZE];
+    std::atomic<uint32_t> writeIndex;
+    std::atomic<uint16_t> nextTraceId;
+
+    bool readEvent(uint32_t index, Event& out) const;
+};
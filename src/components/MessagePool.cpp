@@ -0,0 +1,131 @@
+#include "MessagePool.hpp"
+
+void MessagePool::init() {
+    for (size_t i = 0; i < SLOT_COUNT; i++) {
+        refCount[i] = 0;
+        textBlocks[i] = 0;
+    }
+    textBlockMap = 0;
+    inUse = 0;
+    highWater = 0;
+    allocCount = 0;
+    allocFailures = 0;
+    bytesCopied = 0;
+    lock = portMUX_INITIALIZER_UNLOCKED;
+}
+
+MessageHandle MessagePool::allocate(const LED_PANEL_REQUEST& request) {
+    size_t textLength = 0;
+    size_t blocks = 0;
+    const char* const* source = textField(request);
+    if (source) {
+        textLength = *source ? strlen(*source) : 0;
+        blocks = (textLength + TEXT_BLOCK_SIZE) / TEXT_BLOCK_SIZE;  // Includes terminator
+    }
+
+    MessageHandle handle = INVALID_MESSAGE;
+    int firstBlock = 0;
+
+    taskENTER_CRITICAL(&lock);
+    for (size_t i = 0; i < SLOT_COUNT; i++) {
+        if (refCount[i] == 0) {
+            handle = i;
+            break;
+        }
+    }
+    if (handle != INVALID_MESSAGE && blocks) {
+        firstBlock = allocateTextBlocks(blocks);
+        if (firstBlock < 0) handle = INVALID_MESSAGE;
+    }
+    if (handle != INVALID_MESSAGE) {
+        refCount[handle] = 1;
+        textStart[handle] = firstBlock;
+        textBlocks[handle] = blocks;
+        inUse++;
+        if (inUse > highWater) highWater = inUse;
+        allocCount++;
+    } else {
+        allocFailures++;
+    }
+    taskEXIT_CRITICAL(&lock);
+
+    if (handle == INVALID_MESSAGE) return INVALID_MESSAGE;
+
+    // The slot is owned exclusively by the caller until it is queued
+    slots[handle] = request;
+    bytesCopied += sizeof(LED_PANEL_REQUEST);
+    if (blocks) {
+        char* text = &textArena[firstBlock * TEXT_BLOCK_SIZE];
+        if (textLength) memcpy(text, *source, textLength);
+        text[textLength] = '\0';
+        *textField(slots[handle]) = text;
+        bytesCopied += textLength + 1;
+    }
+
+    return handle;
+}
+
+void MessagePool::retain(MessageHandle handle) {
+    if (handle >= SLOT_COUNT) return;
+
+    taskENTER_CRITICAL(&lock);
+    refCount[handle]++;
+    taskEXIT_CRITICAL(&lock);
+}
+
+void MessagePool::release(MessageHandle handle) {
+    if (handle >= SLOT_COUNT) return;
+
+    taskENTER_CRITICAL(&lock);
+    if (refCount[handle] > 0 && --refCount[handle] == 0) {
+        freeSlot(handle);
+    }
+    taskEXIT_CRITICAL(&lock);
+}
+
+const char* const* MessagePool::textField(const LED_PANEL_REQUEST& request) {
+    switch (request.action) {
+        case SET_HEADER_T:
+        case SET_TIME_T:
+            return &request.data.text;
+        case SET_STATE:
+            return (request.data.state.fields & FIELD_HEADER_TEXT) ? &request.data.state.headerText : nullptr;
+        default:
+            return nullptr;
+    }
+}
+
+const char** MessagePool::textField(LED_PANEL_REQUEST& request) {
+    switch (request.action) {
+        case SET_HEADER_T:
+        case SET_TIME_T:
+            return &request.data.text;
+        case SET_STATE:
+            return (request.data.state.fields & FIELD_HEADER_TEXT) ? &request.data.state.headerText : nullptr;
+        default:
+            return nullptr;
+    }
+}
+
+int MessagePool::allocateTextBlocks(size_t count) {
+    if (count == 0 || count > TEXT_BLOCK_COUNT) return -1;
+
+    // First fit over the block bitmap
+    uint32_t run = (count == 32) ? 0xFFFFFFFFu : ((1u << count) - 1);
+    for (size_t start = 0; start + count <= TEXT_BLOCK_COUNT; start++) {
+        if ((textBlockMap & (run << start)) == 0) {
+            textBlockMap |= run << start;
+            return start;
+        }
+    }
+    return -1;
+}
+
+void MessagePool::freeSlot(MessageHandle handle) {
+    if (textBlocks[handle]) {
+        uint32_t run = (textBlocks[handle] == 32) ? 0xFFFFFFFFu : ((1u << textBlocks[handle]) - 1);
+        textBlockMap &= ~(run << textStart[handle]);
+        textBlocks[handle] = 0;
+    }
+    inUse--;
+}
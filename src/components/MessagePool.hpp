@@ -0,0 +1,65 @@
+#pragma once
+
+#include <freertos/FreeRTOS.h>
+#include "../Types.hpp"
+
+// Small handle passed through the FreeRTOS queues instead of a full request
+typedef uint8_t MessageHandle;
+constexpr MessageHandle INVALID_MESSAGE = 0xFF;
+
+// Fixed pool of reference-counted request slots.
+// The producer allocates a slot (copying any text once into the pool's text
+// arena) and only the one-byte handle travels through displayRing and
+// storageQueue. Display and storage retain/release the same slot, so the
+// payload is shared instead of copied. Text length is limited only by
+// MESSAGE_TEXT_ARENA_SIZE, not by a fixed per-request buffer.
+class MessagePool {
+public:
+    void init();
+
+    // Allocate a slot holding a copy of `request` (refcount 1).
+    // Text (data.text, or data.state.headerText for SET_STATE) is copied
+    // into the arena.
+    MessageHandle allocate(const LED_PANEL_REQUEST& request);
+
+    const LED_PANEL_REQUEST& get(MessageHandle handle) const { return slots[handle]; }
+
+    void retain(MessageHandle handle);
+    void release(MessageHandle handle);
+
+    // Statistics
+    uint8_t getInUse() const { return inUse; }
+    uint8_t getHighWater() const { return highWater; }
+    uint32_t getAllocCount() const { return allocCount; }
+    uint32_t getAllocFailures() const { return allocFailures; }
+    uint32_t getBytesCopied() const { return bytesCopied; }
+
+    static constexpr size_t SLOT_COUNT = 16;
+    static constexpr size_t TEXT_BLOCK_SIZE = 32;
+    static constexpr size_t TEXT_BLOCK_COUNT = MESSAGE_TEXT_ARENA_SIZE / TEXT_BLOCK_SIZE;
+
+private:
+    static_assert(TEXT_BLOCK_COUNT <= 32, "text block map is a 32-bit mask");
+
+    LED_PANEL_REQUEST slots[SLOT_COUNT];
+    uint8_t refCount[SLOT_COUNT];
+    uint8_t textStart[SLOT_COUNT];
+    uint8_t textBlocks[SLOT_COUNT];
+
+    uint32_t textBlockMap;  // One bit per used text block
+    char textArena[TEXT_BLOCK_COUNT * TEXT_BLOCK_SIZE];
+
+    uint8_t inUse;
+    uint8_t highWater;
+    uint32_t allocCount;
+    uint32_t allocFailures;
+    uint32_t bytesCopied;
+
+    portMUX_TYPE lock;
+
+    // Pointer to the request's text member, or nullptr if it carries none
+    static const char* const* textField(const LED_PANEL_REQUEST& request);
+    static const char** textField(LED_PANEL_REQUEST& request);
+    int allocateTextBlocks(size_t count);
+    void freeSlot(MessageHandle handle);
+};
@@ -0,0 +1,211 @@
+#include "PerfProfiler.hpp"
+#include "SystemLogger.hpp"
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+
+void PerfProfiler::init() {
+    sampleHead = 0;
+    sampleCount = 0;
+    counterCount = 0;
+    previousCount = 0;
+    previousTotalRuntime = 0;
+    taskHandle = nullptr;
+    samplesTaken = 0;
+    lock = portMUX_INITIALIZER_UNLOCKED;
+}
+
+void PerfProfiler::start() {
+    xTaskCreatePinnedToCore(
+        profilerTask,
+        "PerfTask",
+        3072,
+        this,
+        1,
+        &taskHandle,
+        0
+    );
+}
+
+bool PerfProfiler::registerCounter(const char* name, uint32_t (*read)()) {
+    if (counterCount >= MAX_COUNTERS) {
+        LOG_E(APP, "PerfProfiler: counter %s dropped, MAX_COUNTERS (%u) reached", name, (uint32_t)MAX_COUNTERS);
+        return false;
+    }
+    counters[counterCount].name = name;
+    counters[counterCount].read = read;
+    counterCount++;
+    return true;
+}
+
+void PerfProfiler::sample() {
+    Sample current;
+    current.timestampMs = millis();
+    current.freeHeap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    current.minFreeHeap = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    current.idlePercent[0] = CPU_UNKNOWN;
+    current.idlePercent[1] = CPU_UNKNOWN;
+    current.taskCount = 0;
+
+    uint32_t totalRuntime = 0;
+    size_t count = uxTaskGetSystemState(status, sizeof(status) / sizeof(status[0]), &totalRuntime);
+
+#if configGENERATE_RUN_TIME_STATS
+    uint32_t totalDelta = totalRuntime - previousTotalRuntime;
+#else
+    uint32_t totalDelta = 0;
+#endif
+
+    TaskHandle_t idle[2] = { xTaskGetIdleTaskHandleForCPU(0), xTaskGetIdleTaskHandleForCPU(1) };
+
+    for (size_t i = 0; i < count; i++) {
+        uint8_t cpu = CPU_UNKNOWN;
+#if configGENERATE_RUN_TIME_STATS
+        if (previousCount && totalDelta) {
+            uint32_t delta = runtimeDelta(status[i].xHandle, status[i].ulRunTimeCounter);
+            uint64_t percent = (uint64_t)delta * 100 / totalDelta;
+            cpu = percent > 100 ? 100 : percent;
+        }
+#endif
+
+        // Idle tasks are reported as per-core idle share, not as tasks
+        if (status[i].xHandle == idle[0] || status[i].xHandle == idle[1]) {
+            current.idlePercent[status[i].xHandle == idle[0] ? 0 : 1] = cpu;
+            continue;
+        }
+
+        if (current.taskCount >= MAX_TASKS) continue;
+
+        TaskSample& task = current.tasks[current.taskCount++];
+        strncpy(task.name, status[i].pcTaskName, sizeof(task.name) - 1);
+        task.name[sizeof(task.name) - 1] = '\0';
+        BaseType_t affinity = xTaskGetAffinity(status[i].xHandle);
+        task.core = (affinity == tskNO_AFFINITY) ? 2 : affinity;
+        task.cpuPercent = cpu;
+        task.stackFree = status[i].usStackHighWaterMark;
+    }
+
+    // Remember runtime counters for the next delta
+    for (size_t i = 0; i < count; i++) {
+        previousHandles[i] = status[i].xHandle;
+        previousRuntime[i] = status[i].ulRunTimeCounter;
+    }
+    previousCount = count;
+    previousTotalRuntime = totalRuntime;
+
+    taskENTER_CRITICAL(&lock);
+    samples[sampleHead] = current;
+    sampleHead = (sampleHead + 1) % PERF_HISTORY_LEN;
+    if (sampleCount < PERF_HISTORY_LEN) sampleCount++;
+    taskEXIT_CRITICAL(&lock);
+}
+
+uint32_t PerfProfiler::runtimeDelta(TaskHandle_t handle, uint32_t runtime) const {
+    for (size_t i = 0; i < previousCount; i++) {
+        if (previousHandles[i] == handle) {
+            return runtime - previousRuntime[i];
+        }
+    }
+    return runtime;  // Task created since the previous sample
+}
+
+size_t PerfProfiler::jsonCapacity() const {
+    // Longest rendering of each part below: 10-digit numbers, -1 for
+    // unknown CPU shares, full-length task names
+    const size_t perDocument = 64;
+    const size_t perSample = 96;
+    const size_t perTask = configMAX_TASK_NAME_LEN + 56;
+    size_t capacity = perDocument + PERF_HISTORY_LEN * (perSample + MAX_TASKS * perTask);
+    for (size_t i = 0; i < counterCount; i++) {
+        capacity += strlen(counters[i].name) + 16;
+    }
+    return capacity;
+}
+
+size_t PerfProfiler::writeJson(char* buffer, size_t size) {
+    size_t used = 0;
+    bool truncated = false;
+    auto append = [&](const char* format, auto... args) {
+        if (truncated) return;
+        int n = snprintf(buffer + used, size - used, format, args...);
+        if (n < 0 || (size_t)n >= size - used) {
+            truncated = true;
+            return;
+        }
+        used += n;
+    };
+
+    append("{\"period_ms\":%u,\"samples\":[", PERF_SAMPLE_PERIOD_MS);
+
+    for (size_t n = 0; n < sampleCount; n++) {
+        // Oldest first; copy out so the profiler task can keep writing
+        Sample s;
+        size_t index = (sampleHead + PERF_HISTORY_LEN - sampleCount + n) % PERF_HISTORY_LEN;
+        taskENTER_CRITICAL(&lock);
+        s = samples[index];
+        taskEXIT_CRITICAL(&lock);
+
+        append("%s{\"t\":%u,\"heap\":%u,\"min_heap\":%u,\"idle\":[%d,%d],\"tasks\":[",
+               n ? "," : "", s.timestampMs, s.freeHeap, s.minFreeHeap,
+               s.idlePercent[0] == CPU_UNKNOWN ? -1 : s.idlePercent[0],
+               s.idlePercent[1] == CPU_UNKNOWN ? -1 : s.idlePercent[1]);
+
+        for (size_t i = 0; i < s.taskCount; i++) {
+            const TaskSample& task = s.tasks[i];
+            append("%s{\"name\":\"%s\",\"core\":%u,\"cpu\":%d,\"stack_free\":%u}",
+                   i ? "," : "", task.name, task.core,
+                   task.cpuPercent == CPU_UNKNOWN ? -1 : task.cpuPercent, task.stackFree);
+        }
+        append("]}");
+    }
+
+    append("],\"counters\":{");
+    for (size_t i = 0; i < counterCount; i++) {
+        append("%s\"%s\":%u", i ? "," : "", counters[i].name, counters[i].read());
+    }
+    append("}}");
+
+    return truncated ? 0 : used;
+}
+
+void PerfProfiler::dumpSerial() {
+    if (sampleCount == 0) return;
+
+    Sample s;
+    taskENTER_CRITICAL(&lock);
+    s = samples[(sampleHead + PERF_HISTORY_LEN - 1) % PERF_HISTORY_LEN];
+    taskEXIT_CRITICAL(&lock);
+
+    // One compact line: idle per core, heap, then name/core/cpu%/stack-free per task
+    Serial.printf("perf t=%u idle=%d/%d heap=%u min=%u |",
+                  s.timestampMs,
+                  s.idlePercent[0] == CPU_UNKNOWN ? -1 : s.idlePercent[0],
+                  s.idlePercent[1] == CPU_UNKNOWN ? -1 : s.idlePercent[1],
+                  s.freeHeap, s.minFreeHeap);
+    for (size_t i = 0; i < s.taskCount; i++) {
+        Serial.printf(" %s:%u:%d%%:%u", s.tasks[i].name, s.tasks[i].core,
+                      s.tasks[i].cpuPercent == CPU_UNKNOWN ? -1 : s.tasks[i].cpuPercent,
+                      s.tasks[i].stackFree);
+    }
+    Serial.println();
+}
+
+void PerfProfiler::tick() {
+    sample();
+    samplesTaken++;
+
+#ifdef DEBUG_LEDSTACK
+    if (samplesTaken % PERF_SERIAL_DUMP_EVERY == 0) {
+        dumpSerial();
+    }
+#endif
+}
+
+void PerfProfiler::profilerTask(void* parameter) {
+    PerfProfiler* profiler = static_cast<PerfProfiler*>(parameter);
+    const TickType_t xDelay = pdMS_TO_TICKS(PERF_SAMPLE_PERIOD_MS);
+
+    while (true) {
+        profiler->tick();
+        vTaskDelay(xDelay);
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "../Config.hpp"
+
+// Sampling profiler for the FreeRTOS tasks.
+// A low-priority task periodically collects per-task CPU share (when the
+// runtime counter is enabled), stack high-water marks, per-core idle share
+// and heap headroom into a small ring of samples. Samples are served as
+// JSON by /api/perf and can be dumped to serial.
+class PerfProfiler {
+public:
+    void init();
+
+    // Create the profiler task; executor mode runs tick() as a job instead
+    void start();
+
+    // Take one sample and dump to serial every PERF_SERIAL_DUMP_EVERY
+    // samples (debug builds); called every PERF_SAMPLE_PERIOD_MS
+    void tick();
+
+    // Take one sample
+    void sample();
+
+    // Extra application counters reported alongside the samples; false
+    // (and an error logged) once MAX_COUNTERS are registered
+    bool registerCounter(const char* name, uint32_t (*read)());
+
+    // Output. jsonCapacity() is enough for a full history of MAX_TASKS
+    // tasks and every registered counter; writeJson() returns 0 if the
+    // output did not fit.
+    size_t jsonCapacity() const;
+    size_t writeJson(char* buffer, size_t size);
+    void dumpSerial();
+
+private:
+    static constexpr size_t MAX_TASKS = 16;
+    static constexpr size_t MAX_COUNTERS = 64;  // main.cpp registers 50
+    static constexpr uint8_t CPU_UNKNOWN = 0xFF;
+
+    struct TaskSample {
+        char name[configMAX_TASK_NAME_LEN];
+        uint8_t core;          // 0, 1 or 2 (no affinity)
+        uint8_t cpuPercent;    // Share of one core since previous sample
+        uint16_t stackFree;    // Stack high-water mark in bytes
+    };
+
+    struct Sample {
+        uint32_t timestampMs;
+        uint32_t freeHeap;
+        uint32_t minFreeHeap;
+        uint8_t idlePercent[2];
+        uint8_t taskCount;
+        TaskSample tasks[MAX_TASKS];
+    };
+
+    struct Counter {
+        const char* name;
+        uint32_t (*read)();
+    };
+
+    // Ring of recent samples
+    Sample samples[PERF_HISTORY_LEN];
+    size_t sampleHead;
+    size_t sampleCount;
+    portMUX_TYPE lock;
+
+    Counter counters[MAX_COUNTERS];
+    size_t counterCount;
+
+    // Runtime counters from the previous sample, used to compute deltas
+    TaskStatus_t status[MAX_TASKS + 8];
+    TaskHandle_t previousHandles[MAX_TASKS + 8];
+    uint32_t previousRuntime[MAX_TASKS + 8];
+    size_t previousCount;
+    uint32_t previousTotalRuntime;
+
+    TaskHandle_t taskHandle;
+    uint32_t samplesTaken;
+
+    uint32_t runtimeDelta(TaskHandle_t handle, uint32_t runtime) const;
+    static void profilerTask(void* parameter);
+};
@@ -0,0 +1,112 @@
+#include "RequestArgs.hpp"
+#include <string.h>
+
+static int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+void RequestArgs::parse(char* buffer) {
+    argCount = 0;
+
+    char* pair = buffer;
+    while (pair && *pair && argCount < MAX_ARGS) {
+        char* next = strchr(pair, '&');
+        if (next) *next++ = '\0';
+
+        char* value = strchr(pair, '=');
+        if (value) {
+            *value++ = '\0';
+        } else {
+            value = pair + strlen(pair);  // "flag" with no value: empty string
+        }
+
+        size_t keyLength = urlDecode(pair);
+        size_t valueLength = urlDecode(value);
+        if (keyLength > 0) {
+            keys[argCount] = std::string_view(pair, keyLength);
+            values[argCount] = std::string_view(value, valueLength);
+            argCount++;
+        }
+
+        pair = next;
+    }
+}
+
+bool RequestArgs::get(std::string_view key, std::string_view& value) const {
+    for (size_t i = 0; i < argCount; i++) {
+        if (keys[i] == key) {
+            value = values[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+bool RequestArgs::parseColor(std::string_view text, uint32_t& color) {
+    if (!text.empty() && text[0] == '#') text.remove_prefix(1);
+    if (text.size() != 6) return false;
+
+    uint32_t result = 0;
+    for (char c : text) {
+        int digit = hexDigit(c);
+        if (digit < 0) return false;
+        result = (result << 4) | digit;
+    }
+    color = result;
+    return true;
+}
+
+bool RequestArgs::parseByte(std::string_view text, uint8_t& value) {
+    uint32_t result;
+    if (!parseUnsigned(text, 255, result)) return false;
+    value = result;
+    return true;
+}
+
+bool RequestArgs::parseUnsigned(std::string_view text, uint32_t max, uint32_t& value) {
+    uint64_t result;
+    if (!parseUnsigned64(text, max, result)) return false;
+    value = result;
+    return true;
+}
+
+bool RequestArgs::parseUnsigned64(std::string_view text, uint64_t max, uint64_t& value) {
+    // 19 digits always fit in 64 bits
+    if (text.empty() || text.size() > 19) return false;
+
+    uint64_t result = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') return false;
+        result = result * 10 + (c - '0');
+    }
+    if (result > max) return false;
+    value = result;
+    return true;
+}
+
+bool RequestArgs::validateText(std::string_view text, size_t minLength, size_t maxLength) {
+    if (text.size() < minLength || text.size() > maxLength) return false;
+    for (char c : text) {
+        if ((unsigned char)c < 0x20 || c == 0x7F) return false;
+    }
+    return true;
+}
+
+size_t RequestArgs::urlDecode(char* text) {
+    char* out = text;
+    for (const char* in = text; *in; in++) {
+        if (*in == '+') {
+            *out++ = ' ';
+        } else if (*in == '%' && hexDigit(in[1]) >= 0 && hexDigit(in[2]) >= 0) {
+            *out++ = (char)((hexDigit(in[1]) << 4) | hexDigit(in[2]));
+            in += 2;
+        } else {
+            *out++ = *in;
+        }
+    }
+    *out = '\0';
+    return out - text;
+}
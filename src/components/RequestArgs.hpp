@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string_view>
+
+// Zero-allocation view of urlencoded request arguments ("a=1&b=2", from
+// the query string and/or a form body). parse() url-decodes the buffer in
+// place and records string_views over it; every value is also
+// NUL-terminated in the buffer, so value.data() can be handed on as a C
+// string. The views are valid until the buffer is reused.
+class RequestArgs {
+public:
+    static constexpr size_t MAX_ARGS = 8;
+
+    // Split and decode `buffer` in place; arguments beyond MAX_ARGS are ignored
+    void parse(char* buffer);
+
+    // Value of `key`; false if it is absent
+    bool get(std::string_view key, std::string_view& value) const;
+
+    size_t count() const { return argCount; }
+
+    // Typed validators. They accept the whole view or nothing.
+
+    // "RRGGBB" or "#RRGGBB"
+    static bool parseColor(std::string_view text, uint32_t& color);
+
+    // Decimal 0..255
+    static bool parseByte(std::string_view text, uint8_t& value);
+
+    // Decimal 0..max
+    static bool parseUnsigned(std::string_view text, uint32_t max, uint32_t& value);
+    static bool parseUnsigned64(std::string_view text, uint64_t max, uint64_t& value);
+
+    // Text of minLength..maxLength bytes without control characters
+    static bool validateText(std::string_view text, size_t minLength, size_t maxLength);
+
+private:
+    std::string_view keys[MAX_ARGS];
+    std::string_view values[MAX_ARGS];
+    size_t argCount = 0;
+
+    // Decode %XX escapes and '+' in place; returns the decoded length
+    static size_t urlDecode(char* text);
+};
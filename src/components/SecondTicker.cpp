@@ -0,0 +1,80 @@
+#include "SecondTicker.hpp"
+#include <string.h>
+
+static int64_t floorDiv(int64_t value, int64_t divisor) {
+    int64_t quotient = value / divisor;
+    return (value % divisor < 0) ? quotient - 1 : quotient;
+}
+
+void SecondTicker::init(ClockFunction clock, ArmFunction arm, TickFunction tick, uint32_t maxRatePpm) {
+    this->clock = clock;
+    this->arm = arm;
+    this->tick = tick;
+    this->maxRatePpm = maxRatePpm;
+    started = false;
+    lastSecond = 0;
+    nextSecond = 0;
+    memset(&stats, 0, sizeof(stats));
+    totalLatenessUs = 0;
+    timedTicks = 0;
+}
+
+void SecondTicker::start() {
+    started = false;
+    fire();
+}
+
+void SecondTicker::fire() {
+    int64_t now = clock();
+    int64_t second = floorDiv(now, US_PER_S);
+
+    // Short of the boundary armed for: the shortened wait ended early, or
+    // the clock was stepped back but not past the second shown
+    if (started && second >= lastSecond && second < nextSecond) {
+        stats.rearms++;
+        armForNextBoundary();
+        return;
+    }
+
+    bool consecutive = started && second == lastSecond + 1;
+    started = true;
+    lastSecond = second;
+    tick(second);
+
+    // Lateness is only meaningful for a boundary that was waited for
+    if (consecutive) {
+        uint32_t lateness = now - second * US_PER_S;
+        stats.lastLatenessUs = lateness;
+        if (lateness > stats.maxLatenessUs) stats.maxLatenessUs = lateness;
+        if (lateness >= MISS_US) stats.missed++;
+        totalLatenessUs += lateness;
+        timedTicks++;
+        stats.avgLatenessUs = totalLatenessUs / timedTicks;
+    } else if (stats.ticks) {
+        stats.jumps++;
+    }
+    stats.ticks++;
+
+    armForNextBoundary();
+}
+
+void SecondTicker::armForNextBoundary() {
+    int64_t now = clock();
+    nextSecond = floorDiv(now, US_PER_S) + 1;
+    int64_t remaining = nextSecond * US_PER_S - now;
+
+    // The timer may run up to maxRatePpm fast or slow against the wall
+    // clock. For a long wait, aim to land early and come back for the
+    // rest; for a short one, aim to land at or just after the boundary.
+    int64_t slower = (remaining * maxRatePpm + US_PER_S + maxRatePpm - 1) / (US_PER_S + maxRatePpm);
+    if (slower >= SPLIT_ABOVE_US) {
+        arm(remaining - slower);
+    } else {
+        int64_t faster = (remaining * maxRatePpm + US_PER_S - maxRatePpm - 1) / (US_PER_S - maxRatePpm);
+        arm(remaining + faster + 1);
+    }
+}
+
+SecondTicker::Stats SecondTicker::getStats() const {
+    return stats;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdint.h>
+
+// Runs a job on every second boundary of a wall clock that may be slewed
+// or stepped underneath it (TimeSync).
+// The timer is one-shot and re-armed after every firing from a fresh
+// reading of the wall clock, so phase errors never accumulate. While the
+// wall clock is slewed it runs up to `maxRatePpm` apart from the timer:
+// long waits are shortened by that much and the rest of the second is
+// armed again on the early firing, so the job starts late by little more
+// than the timer's dispatch latency.
+//
+// No ESP-IDF dependency: the clock and the timer are passed in, so the
+// scheduling can be run on the host against a mock clock (tools/clock_sim).
+class SecondTicker {
+public:
+    typedef int64_t (*ClockFunction)();                 // Wall clock in microseconds
+    typedef void (*ArmFunction)(uint64_t delayUs);      // Start the one-shot timer
+    typedef void (*TickFunction)(int64_t second);       // Whole seconds of the wall clock
+
+    struct Stats {
+        uint32_t ticks;
+        uint32_t lastLatenessUs;    // Job start after its boundary
+        uint32_t maxLatenessUs;
+        uint32_t avgLatenessUs;
+        uint32_t missed;            // Ticks starting MISS_US or more after the boundary
+        uint32_t rearms;            // Early firings armed again for the rest of the second
+        uint32_t jumps;             // Ticks not following the previous second (clock stepped, job overran)
+    };
+
+    static constexpr uint32_t MISS_US = 1000;
+
+    void init(ClockFunction clock, ArmFunction arm, TickFunction tick, uint32_t maxRatePpm);
+
+    // Run the job for the current second now and arm for the next boundary
+    void start();
+
+    // Timer callback
+    void fire();
+
+    Stats getStats() const;
+
+private:
+    static constexpr int64_t US_PER_S = 1000000;
+
+    // Waits with less rate error than this are not split in two
+    static constexpr int64_t SPLIT_ABOVE_US = 50;
+
+    ClockFunction clock;
+    ArmFunction arm;
+    TickFunction tick;
+    uint32_t maxRatePpm;
+
+    bool started;
+    int64_t lastSecond;         // Last second handed to the job
+    int64_t nextSecond;         // Second whose boundary the timer is armed for
+
+    Stats stats;
+    uint64_t totalLatenessUs;
+    uint32_t timedTicks;
+
+    void armForNextBoundary();
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+// Versioned snapshot of a small trivially-copyable struct, shared across
+// cores without locks. One writer publishes; any number of readers take
+// consistent copies and retry if they overlap a publish. The payload is
+// stored as atomic words (release on write, acquire on read, no fences) so
+// concurrent access is well defined and thread-sanitizer clean.
+//
+// Each instance must have a single writer task. State with several
+// publishers should be split into one SeqLock per publisher.
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock payload must be trivially copyable");
+
+public:
+    void publish(const T& value) {
+        uint32_t words[WORD_COUNT] = {};
+        memcpy(words, &value, sizeof(T));
+
+        const uint32_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);  // Odd: write in progress
+
+        // A reader that observes any new word is guaranteed to see the odd sequence
+        for (size_t i = 0; i < WORD_COUNT; i++) {
+            data[i].store(words[i], std::memory_order_release);
+        }
+
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // Copy the latest snapshot into `out` and return its version
+    uint32_t read(T& out) const {
+        uint32_t words[WORD_COUNT];
+        uint32_t before;
+        uint32_t after;
+
+        do {
+            before = sequence.load(std::memory_order_acquire);
+            for (size_t i = 0; i < WORD_COUNT; i++) {
+                words[i] = data[i].load(std::memory_order_acquire);
+            }
+            after = sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+
+        memcpy(&out, words, sizeof(T));
+        return before / 2;
+    }
+
+    // Number of completed publishes; cheap check before calling read()
+    uint32_t version() const {
+        return sequence.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    static constexpr size_t WORD_COUNT = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    std::atomic<uint32_t> sequence{0};
+    std::atomic<uint32_t> data[WORD_COUNT] = {};
+};
@@ -0,0 +1,136 @@
+#include "SessionTokens.hpp"
+#include <esp_system.h>
+#include <string.h>
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+static void writeHex(char* out, const uint8_t* bytes, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        out[2 * i] = HEX_DIGITS[bytes[i] >> 4];
+        out[2 * i + 1] = HEX_DIGITS[bytes[i] & 0x0F];
+    }
+}
+
+// Lower-case only, matching what issue() writes
+static bool readHex(const char* in, uint8_t* bytes, size_t count) {
+    for (size_t i = 0; i < 2 * count; i++) {
+        char c = in[i];
+        uint8_t digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else {
+            return false;
+        }
+        bytes[i / 2] = (i & 1) ? (bytes[i / 2] | digit) : (digit << 4);
+    }
+    return true;
+}
+
+static void putU32(uint8_t* out, uint32_t value) {
+    out[0] = value >> 24;
+    out[1] = value >> 16;
+    out[2] = value >> 8;
+    out[3] = value;
+}
+
+static uint32_t getU32(const uint8_t* in) {
+    return ((uint32_t)in[0] << 24) | ((uint32_t)in[1] << 16) | ((uint32_t)in[2] << 8) | in[3];
+}
+
+void SessionTokens::init() {
+    mbedtls_md_init(&hmac);
+    // The one allocation: the SHA-256 context and ipad/opad, kept for good
+    mbedtls_md_setup(&hmac, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 1);
+    nextId = esp_random();
+    revokeAll();
+}
+
+void SessionTokens::revokeAll() {
+    uint8_t key[32];
+    esp_fill_random(key, sizeof(key));
+    mbedtls_md_hmac_starts(&hmac, key, sizeof(key));
+    memset(key, 0, sizeof(key));
+
+    for (size_t i = 0; i < SESSION_MAX_REVOKED; i++) {
+        revoked[i].expiresS = 0;
+    }
+}
+
+void SessionTokens::sign(uint32_t id, uint32_t expiresS, uint8_t* mac) {
+    uint8_t message[8];
+    putU32(message, id);
+    putU32(message + 4, expiresS);
+
+    uint8_t digest[32];
+    mbedtls_md_hmac_reset(&hmac);
+    mbedtls_md_hmac_update(&hmac, message, sizeof(message));
+    mbedtls_md_hmac_finish(&hmac, digest);
+    memcpy(mac, digest, MAC_LENGTH);
+}
+
+void SessionTokens::issue(char* token, uint32_t nowS) {
+    uint8_t raw[8 + MAC_LENGTH];
+    uint32_t id = nextId++;
+    uint32_t expiresS = nowS + SESSION_TOKEN_TTL_S;
+    putU32(raw, id);
+    putU32(raw + 4, expiresS);
+    sign(id, expiresS, raw + 8);
+
+    writeHex(token, raw, sizeof(raw));
+    token[TOKEN_LENGTH] = '\0';
+}
+
+bool SessionTokens::decode(const char* token, size_t length, uint32_t& id, uint32_t& expiresS) {
+    uint8_t raw[8 + MAC_LENGTH];
+    if (length != TOKEN_LENGTH || !readHex(token, raw, sizeof(raw))) {
+        return false;
+    }
+    id = getU32(raw);
+    expiresS = getU32(raw + 4);
+
+    uint8_t mac[MAC_LENGTH];
+    sign(id, expiresS, mac);
+    return equals((const char*)raw + 8, MAC_LENGTH, (const char*)mac, MAC_LENGTH);
+}
+
+bool SessionTokens::verify(const char* token, size_t length, uint32_t nowS) {
+    uint32_t id, expiresS;
+    if (!decode(token, length, id, expiresS) || nowS >= expiresS) {
+        return false;
+    }
+    for (size_t i = 0; i < SESSION_MAX_REVOKED; i++) {
+        if (revoked[i].expiresS > nowS && revoked[i].id == id) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SessionTokens::revoke(const char* token, size_t length, uint32_t nowS) {
+    uint32_t id, expiresS;
+    if (!decode(token, length, id, expiresS) || nowS >= expiresS) {
+        return;  // Already useless
+    }
+
+    // Entries whose token has expired are free again
+    for (size_t i = 0; i < SESSION_MAX_REVOKED; i++) {
+        if (revoked[i].expiresS <= nowS) {
+            revoked[i].id = id;
+            revoked[i].expiresS = expiresS;
+            return;
+        }
+    }
+    revokeAll();
+}
+
+bool SessionTokens::equals(const char* text, size_t length, const char* expected, size_t expectedLength) {
+    uint8_t difference = length != expectedLength;
+    for (size_t i = 0; i < expectedLength; i++) {
+        // Past the end of `text`, keep comparing against expected itself
+        char c = i < length ? text[i] : expected[i] ^ 1;
+        difference |= c ^ expected[i];
+    }
+    return difference == 0;
+}
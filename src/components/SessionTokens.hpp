@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <mbedtls/md.h>
+#include "../Config.hpp"
+
+// HMAC-signed session tokens for the web API.
+// A token is 48 hex characters: session id, expiry (seconds since boot) and
+// the first 16 bytes of HMAC-SHA256(key, id || expiry). Verifying one is a
+// hex decode, one HMAC over 8 bytes and a constant-time compare; the HMAC
+// context keeps its keyed pads from init(), so nothing is allocated per
+// check. The key is random per boot, so a reboot logs everyone out.
+//
+// Not thread-safe: only the HTTP server task issues and checks tokens.
+class SessionTokens {
+public:
+    static constexpr size_t TOKEN_LENGTH = 48;
+
+    void init();
+
+    // Write a new NUL-terminated token into `token` (TOKEN_LENGTH + 1 bytes)
+    void issue(char* token, uint32_t nowS);
+
+    // True if `token` is well formed, signed with the current key, not
+    // expired and not revoked
+    bool verify(const char* token, size_t length, uint32_t nowS);
+
+    // Reject `token` until it expires. If the revocation list is full the
+    // key is rotated instead, which revokes every token.
+    void revoke(const char* token, size_t length, uint32_t nowS);
+
+    // New key: every issued token stops verifying
+    void revokeAll();
+
+    // Compare without an early exit; the time depends only on expectedLength
+    static bool equals(const char* text, size_t length, const char* expected, size_t expectedLength);
+
+private:
+    static constexpr size_t MAC_LENGTH = 16;
+
+    struct Revoked {
+        uint32_t id;
+        uint32_t expiresS;
+    };
+
+    mbedtls_md_context_t hmac;
+    uint32_t nextId;
+    Revoked revoked[SESSION_MAX_REVOKED];
+
+    void sign(uint32_t id, uint32_t expiresS, uint8_t* mac);
+
+    // Decode id and expiry and check the signature
+    bool decode(const char* token, size_t length, uint32_t& id, uint32_t& expiresS);
+};
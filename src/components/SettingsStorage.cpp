@@ -1,8 +1,12 @@
 #include "SettingsStorage.hpp"
 #include <Arduino.h>
+#include <esp_timer.h>
 
 void SettingsStorage::init() {
     isInitialized = false;
+    commitCount = 0;
+    bytesWritten = 0;
+    maxSaveUs = 0;
 
     // Initialize NVS flash
     esp_err_t err = nvs_flash_init();
@@ -59,48 +63,65 @@ bool SettingsStorage::loadSettings(DisplaySettings& settings) {
 }
 
 bool SettingsStorage::saveSettings(const DisplaySettings& settings) {
+    bool success = saveFields(settings, FIELD_PERSISTENT_MASK);
+
+    if (success) {
+        Serial.println("Settings saved to NVS");
+    } else {
+        Serial.println("Failed to save settings to NVS");
+    }
+
+    return success;
+}
+
+bool SettingsStorage::saveFields(const DisplaySettings& settings, uint8_t fields) {
+    int64_t start = esp_timer_get_time();
     if (!openNVS()) return false;
 
     bool success = true;
+    size_t payload = 0;
 
     // Save brightness
-    if (nvs_set_u8(nvsHandle, KEY_BRIGHTNESS, settings.brightness) != ESP_OK) {
-        success = false;
+    if (fields & FIELD_BRIGHTNESS) {
+        success &= (nvs_set_u8(nvsHandle, KEY_BRIGHTNESS, settings.brightness) == ESP_OK);
+        payload += sizeof(settings.brightness);
     }
 
     // Save header color
-    if (nvs_set_u32(nvsHandle, KEY_HEADER_COLOR, settings.headerColor) != ESP_OK) {
-        success = false;
+    if (fields & FIELD_HEADER_COLOR) {
+        success &= (nvs_set_u32(nvsHandle, KEY_HEADER_COLOR, settings.headerColor) == ESP_OK);
+        payload += sizeof(settings.headerColor);
     }
 
     // Save time color
-    if (nvs_set_u32(nvsHandle, KEY_TIME_COLOR, settings.timeColor) != ESP_OK) {
-        success = false;
+    if (fields & FIELD_TIME_COLOR) {
+        success &= (nvs_set_u32(nvsHandle, KEY_TIME_COLOR, settings.timeColor) == ESP_OK);
+        payload += sizeof(settings.timeColor);
     }
 
     // Save background color
-    if (nvs_set_u32(nvsHandle, KEY_BG_COLOR, settings.bgColor) != ESP_OK) {
-        success = false;
+    if (fields & FIELD_BG_COLOR) {
+        success &= (nvs_set_u32(nvsHandle, KEY_BG_COLOR, settings.bgColor) == ESP_OK);
+        payload += sizeof(settings.bgColor);
     }
 
     // Save header text
-    if (nvs_set_str(nvsHandle, KEY_HEADER_TEXT, settings.headerText) != ESP_OK) {
-        success = false;
+    if (fields & FIELD_HEADER_TEXT) {
+        success &= (nvs_set_str(nvsHandle, KEY_HEADER_TEXT, settings.headerText) == ESP_OK);
+        payload += strlen(settings.headerText) + 1;
     }
 
-    // Commit changes
-    if (nvs_commit(nvsHandle) != ESP_OK) {
+    // Commit all changed fields at once
+    if (!commitNVS(payload)) {
         success = false;
     }
 
     closeNVS();
 
-    if (success) {
-        Serial.println("Settings saved to NVS");
-    } else {
-        Serial.println("Failed to save settings to NVS");
+    uint32_t elapsedUs = (uint32_t)(esp_timer_get_time() - start);
+    if (elapsedUs > maxSaveUs) {
+        maxSaveUs = elapsedUs;
     }
-
     return success;
 }
 
@@ -109,7 +130,7 @@ bool SettingsStorage::saveBrightness(uint8_t brightness) {
 
     bool success = (nvs_set_u8(nvsHandle, KEY_BRIGHTNESS, brightness) == ESP_OK);
     if (success) {
-        success = (nvs_commit(nvsHandle) == ESP_OK);
+        success = commitNVS(sizeof(brightness));
     }
 
     closeNVS();
@@ -121,7 +142,7 @@ bool SettingsStorage::saveHeaderText(const char* text) {
 
     bool success = (nvs_set_str(nvsHandle, KEY_HEADER_TEXT, text) == ESP_OK);
     if (success) {
-        success = (nvs_commit(nvsHandle) == ESP_OK);
+        success = commitNVS(strlen(text) + 1);
     }
 
     closeNVS();
@@ -133,7 +154,7 @@ bool SettingsStorage::saveHeaderColor(uint32_t color) {
 
     bool success = (nvs_set_u32(nvsHandle, KEY_HEADER_COLOR, color) == ESP_OK);
     if (success) {
-        success = (nvs_commit(nvsHandle) == ESP_OK);
+        success = commitNVS(sizeof(color));
     }
 
     closeNVS();
@@ -145,7 +166,7 @@ bool SettingsStorage::saveTimeColor(uint32_t color) {
 
     bool success = (nvs_set_u32(nvsHandle, KEY_TIME_COLOR, color) == ESP_OK);
     if (success) {
-        success = (nvs_commit(nvsHandle) == ESP_OK);
+        success = commitNVS(sizeof(color));
     }
 
     closeNVS();
@@ -157,7 +178,7 @@ bool SettingsStorage::saveBgColor(uint32_t color) {
 
     bool success = (nvs_set_u32(nvsHandle, KEY_BG_COLOR, color) == ESP_OK);
     if (success) {
-        success = (nvs_commit(nvsHandle) == ESP_OK);
+        success = commitNVS(sizeof(color));
     }
 
     closeNVS();
@@ -169,7 +190,7 @@ bool SettingsStorage::clearSettings() {
 
     bool success = (nvs_erase_all(nvsHandle) == ESP_OK);
     if (success) {
-        success = (nvs_commit(nvsHandle) == ESP_OK);
+        success = commitNVS(0);
     }
 
     closeNVS();
@@ -199,3 +220,13 @@ bool SettingsStorage::openNVS() {
 void SettingsStorage::closeNVS() {
     nvs_close(nvsHandle);
 }
+
+bool SettingsStorage::commitNVS(size_t payloadBytes) {
+    if (nvs_commit(nvsHandle) != ESP_OK) {
+        return false;
+    }
+
+    commitCount++;
+    bytesWritten += payloadBytes;
+    return true;
+}
@@ -14,6 +14,9 @@ public:
     // Write operations
     bool saveSettings(const DisplaySettings& settings);
 
+    // Save only the fields in `fields` (DISPLAY_FIELD bits) with a single commit
+    bool saveFields(const DisplaySettings& settings, uint8_t fields);
+
     // Individual parameter operations (convenience methods)
     bool saveBrightness(uint8_t brightness);
     bool saveHeaderText(const char* text);
@@ -24,10 +27,19 @@ public:
     // Clear all stored settings
     bool clearSettings();
 
+    // Write statistics
+    uint32_t getCommitCount() const { return commitCount; }
+    uint32_t getBytesWritten() const { return bytesWritten; }
+    uint32_t getMaxSaveUs() const { return maxSaveUs; }
+
 private:
     nvs_handle_t nvsHandle;
     bool isInitialized;
 
+    uint32_t commitCount;   // nvs_commit calls since boot
+    uint32_t bytesWritten;  // Value payload bytes handed to nvs_set_*
+    uint32_t maxSaveUs;     // Slowest saveFields() since boot, open to close
+
     static constexpr const char* NVS_NAMESPACE = "ledstack";
 
     // NVS keys
@@ -40,4 +52,5 @@ private:
     // Helper methods
     bool openNVS();
     void closeNVS();
+    bool commitNVS(size_t payloadBytes);
 };
\ No newline at end of file
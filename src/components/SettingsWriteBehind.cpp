@@ -0,0 +1,113 @@
+#include "SettingsWriteBehind.hpp"
+#include "SystemLogger.hpp"
+#include "../Config.hpp"
+#include <Arduino.h>
+
+void SettingsWriteBehind::init(SettingsStorage* storage, SemaphoreHandle_t nvsMutex) {
+    this->storage = storage;
+    this->nvsMutex = nvsMutex;
+    dirtyFields = 0;
+    lastChangeMs = 0;
+    deferred = 0;
+}
+
+bool SettingsWriteBehind::markDirty(const LED_PANEL_REQUEST& request) {
+    if (xSemaphoreTake(nvsMutex, 0) != pdTRUE) {
+        deferred++;
+        return false;
+    }
+
+    switch (request.action) {
+        case SET_HEADER_T:
+            strncpy(cache.headerText, request.data.text, sizeof(cache.headerText) - 1);
+            cache.headerText[sizeof(cache.headerText) - 1] = '\0';
+            dirtyFields |= FIELD_HEADER_TEXT;
+            break;
+        case SET_HEADER_COL:
+            cache.headerColor = request.data.color;
+            dirtyFields |= FIELD_HEADER_COLOR;
+            break;
+        case SET_TIME_COL:
+            cache.timeColor = request.data.color;
+            dirtyFields |= FIELD_TIME_COLOR;
+            break;
+        case SET_BG_COL:
+            cache.bgColor = request.data.color;
+            dirtyFields |= FIELD_BG_COLOR;
+            break;
+        case SET_LED_BRIGHT:
+            cache.brightness = request.data.brightness;
+            dirtyFields |= FIELD_BRIGHTNESS;
+            break;
+        case SET_STATE: {
+            const DisplayStatePatch& state = request.data.state;
+            if (state.fields & FIELD_HEADER_TEXT) {
+                strncpy(cache.headerText, state.headerText, sizeof(cache.headerText) - 1);
+                cache.headerText[sizeof(cache.headerText) - 1] = '\0';
+            }
+            if (state.fields & FIELD_HEADER_COLOR) cache.headerColor = state.headerColor;
+            if (state.fields & FIELD_TIME_COLOR)   cache.timeColor = state.timeColor;
+            if (state.fields & FIELD_BG_COLOR)     cache.bgColor = state.bgColor;
+            if (state.fields & FIELD_BRIGHTNESS)   cache.brightness = state.brightness;
+            dirtyFields |= state.fields & FIELD_PERSISTENT_MASK;
+            break;
+        }
+        default:
+            break;
+    }
+    lastChangeMs = millis();
+
+    xSemaphoreGive(nvsMutex);
+    return true;
+}
+
+bool SettingsWriteBehind::flushIfQuiet() {
+    if (!dirtyFields) return true;
+    if (millis() - lastChangeMs < SETTINGS_QUIET_PERIOD_MS) return true;
+
+    // The power-loss flush may be committing; try again next period
+    if (xSemaphoreTake(nvsMutex, 0) != pdTRUE) {
+        deferred++;
+        return false;
+    }
+    bool success = commitLocked();
+    xSemaphoreGive(nvsMutex);
+    return success;
+}
+
+bool SettingsWriteBehind::flush(uint32_t budgetUs) {
+    // A holder is mid-merge or mid-commit; waiting for it is not in budget
+    if (xSemaphoreTake(nvsMutex, 0) != pdTRUE) {
+        LOG_W(STORAGE, "WriteBehind: flush skipped, cache busy");
+        return false;
+    }
+
+    uint32_t expectedUs = storage->getMaxSaveUs();
+    if (expectedUs < SETTINGS_SAVE_ESTIMATE_US) {
+        expectedUs = SETTINGS_SAVE_ESTIMATE_US;
+    }
+    if (dirtyFields && expectedUs > budgetUs) {
+        xSemaphoreGive(nvsMutex);
+        LOG_W(STORAGE, "WriteBehind: flush skipped, commit takes %u us of %u left",
+              expectedUs, budgetUs);
+        return false;
+    }
+    bool success = commitLocked();
+    xSemaphoreGive(nvsMutex);
+    return success;
+}
+
+bool SettingsWriteBehind::commitLocked() {
+    if (!dirtyFields) return true;
+
+    uint8_t fields = dirtyFields;
+    if (!storage->saveFields(cache, fields)) {
+        LOG_W(STORAGE, "WriteBehind: commit failed, will retry");
+        return false;
+    }
+    dirtyFields = 0;
+
+    LOG_I(STORAGE, "WriteBehind: committed fields=0x%02X (commits=%u, bytes=%u)",
+          fields, storage->getCommitCount(), storage->getBytesWritten());
+    return true;
+}
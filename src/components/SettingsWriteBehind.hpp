@@ -0,0 +1,46 @@
+#pragma once
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "SettingsStorage.hpp"
+#include "../Types.hpp"
+
+// Write-behind cache in front of SettingsStorage.
+// Changes are merged into an in-RAM copy of DisplaySettings and tracked in a
+// dirty mask; once no change has arrived for SETTINGS_QUIET_PERIOD_MS all
+// dirty fields are committed in a single NVS transaction.
+//
+// markDirty() and flushIfQuiet() only try the NVS lock, so they can run as
+// executor jobs: while the other side holds it they return false and the
+// caller retries on its next run.
+class SettingsWriteBehind {
+public:
+    void init(SettingsStorage* storage, SemaphoreHandle_t nvsMutex);
+
+    // Merge a request into the cache and restart the quiet period; false
+    // (request not merged) while a commit holds the cache
+    bool markDirty(const LED_PANEL_REQUEST& request);
+
+    // Commit dirty fields if the quiet period has elapsed; false if the
+    // commit failed or was deferred because the cache was busy
+    bool flushIfQuiet();
+
+    // Commit dirty fields immediately (e.g. on power loss) if that fits in
+    // budgetUs, judged by the slowest commit so far; never waits for the
+    // lock. False if it skipped or failed the commit.
+    bool flush(uint32_t budgetUs);
+
+    uint8_t getDirtyFields() const { return dirtyFields; }
+    uint32_t getDeferred() const { return deferred; }
+
+private:
+    SettingsStorage* storage;
+    SemaphoreHandle_t nvsMutex;
+
+    DisplaySettings cache;
+    uint8_t dirtyFields;
+    uint32_t lastChangeMs;
+    uint32_t deferred;        // markDirty/flushIfQuiet calls that found the lock taken
+
+    bool commitLocked();
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+
+// Lock-free single-producer/single-consumer ring buffer.
+// Exactly one task may call push() and exactly one task may call pop();
+// the two may run on different cores. Neither side ever blocks: push()
+// fails when the ring is full and pop() fails when it is empty.
+// One slot is kept free to tell full from empty, so capacity is N - 1.
+template <typename T, size_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "ring size must be a power of two");
+
+public:
+    bool push(const T& item) {
+        const size_t head = writeIndex.load(std::memory_order_relaxed);
+        const size_t next = (head + 1) & MASK;
+        if (next == readIndex.load(std::memory_order_acquire)) {
+            return false;  // Full
+        }
+        buffer[head] = item;
+        writeIndex.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item) {
+        const size_t tail = readIndex.load(std::memory_order_relaxed);
+        if (tail == writeIndex.load(std::memory_order_acquire)) {
+            return false;  // Empty
+        }
+        item = buffer[tail];
+        readIndex.store((tail + 1) & MASK, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called concurrently with push/pop
+    size_t size() const {
+        return (writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_acquire)) & MASK;
+    }
+
+    static constexpr size_t capacity() { return N - 1; }
+
+private:
+    static constexpr size_t MASK = N - 1;
+
+    T buffer[N];
+    std::atomic<size_t> writeIndex{0};  // Written by producer only
+    std::atomic<size_t> readIndex{0};   // Written by consumer only
+};
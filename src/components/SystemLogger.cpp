@@ -0,0 +1,135 @@
+#include "SystemLogger.hpp"
+
+static_assert(LOG_MAX_ARGS == 4, "SystemLogger::output passes exactly four arguments");
+#if LOG_OUTPUT_BINARY
+static_assert(sizeof(void*) == 4, "tools/log_decode.py expects 32-bit format pointers");
+#endif
+
+SystemLogger systemLogger;
+
+void SystemLogger::init() {
+    // Bounded MPMC ring (Vyukov): slot i is free for position i
+    for (uint32_t i = 0; i < LOG_RING_SIZE; i++) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    enqueuePosition.store(0, std::memory_order_relaxed);
+    dequeuePosition = 0;
+    dropped.store(0, std::memory_order_relaxed);
+    logged.store(0, std::memory_order_relaxed);
+    totalCycles.store(0, std::memory_order_relaxed);
+    maxCycles.store(0, std::memory_order_relaxed);
+}
+
+void SystemLogger::start() {
+    xTaskCreatePinnedToCore(
+        drainTask,
+        "LogTask",
+        3072,
+        this,
+        1,
+        NULL,
+        0
+    );
+}
+
+SystemLogger::Slot* SystemLogger::claim() {
+    uint32_t position = enqueuePosition.load(std::memory_order_relaxed);
+
+    while (true) {
+        Slot& slot = slots[position & (LOG_RING_SIZE - 1)];
+        int32_t diff = (int32_t)(slot.sequence.load(std::memory_order_acquire) - position);
+
+        if (diff == 0) {
+            if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                return &slot;
+            }
+        } else if (diff < 0) {
+            dropped.fetch_add(1, std::memory_order_relaxed);  // Ring full
+            return nullptr;
+        } else {
+            position = enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void SystemLogger::commit(Slot* slot, uint32_t cycles) {
+    uint32_t position = slot->sequence.load(std::memory_order_relaxed);
+    slot->sequence.store(position + 1, std::memory_order_release);
+    logged.fetch_add(1, std::memory_order_relaxed);
+
+    // Statistics only: the maximum may miss a concurrent larger value
+    totalCycles.fetch_add(cycles, std::memory_order_relaxed);
+    if (cycles > maxCycles.load(std::memory_order_relaxed)) {
+        maxCycles.store(cycles, std::memory_order_relaxed);
+    }
+}
+
+uint32_t SystemLogger::getAvgCycles() const {
+    uint32_t count = logged.load(std::memory_order_relaxed);
+    return count ? totalCycles.load(std::memory_order_relaxed) / count : 0;
+}
+
+void SystemLogger::encode(Record& record, size_t index, const char* text) {
+    size_t space = sizeof(record.strings) - record.stringUsed;
+    if (!text) text = "(null)";
+
+    record.stringMask |= 1 << index;
+
+    if (space == 0) {
+        record.args[index] = sizeof(record.strings) - 1;  // Terminator of the previous string
+        return;
+    }
+    record.args[index] = record.stringUsed;
+
+    size_t length = strnlen(text, space - 1);
+    memcpy(&record.strings[record.stringUsed], text, length);
+    record.strings[record.stringUsed + length] = '\0';
+    record.stringUsed += length + 1;
+}
+
+void SystemLogger::drain() {
+    while (true) {
+        Slot& slot = slots[dequeuePosition & (LOG_RING_SIZE - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != dequeuePosition + 1) {
+            break;  // Empty, or the next record is still being written
+        }
+
+        output(slot.record);
+
+        slot.sequence.store(dequeuePosition + LOG_RING_SIZE, std::memory_order_release);
+        dequeuePosition++;
+    }
+}
+
+void SystemLogger::output(const Record& record) {
+#if LOG_OUTPUT_BINARY
+    // Frame: 0xA5 0x5A, then the raw record. tools/log_decode.py resolves
+    // the format pointer to its string in the firmware ELF.
+    static const uint8_t MAGIC[2] = { 0xA5, 0x5A };
+    Serial.write(MAGIC, sizeof(MAGIC));
+    Serial.write(reinterpret_cast<const uint8_t*>(&record), sizeof(record));
+#else
+    uint64_t us = record.timestampUs;
+
+    uintptr_t args[LOG_MAX_ARGS] = {};
+    for (size_t i = 0; i < record.argCount; i++) {
+        args[i] = (record.stringMask & (1 << i))
+                      ? (uintptr_t)&record.strings[record.args[i]]
+                      : (uintptr_t)record.args[i];
+    }
+
+    char line[160];
+    snprintf(line, sizeof(line), record.format, args[0], args[1], args[2], args[3]);
+    Serial.printf("[%llu.%03llu c%u] %s\n", us / 1000, us % 1000, record.core, line);
+#endif
+}
+
+void SystemLogger::drainTask(void* parameter) {
+    SystemLogger* logger = static_cast<SystemLogger*>(parameter);
+    const TickType_t xDelay = pdMS_TO_TICKS(LOG_DRAIN_PERIOD_MS);
+
+    while (true) {
+        logger->drain();
+        vTaskDelay(xDelay);
+    }
+}
@@ -1 +1,145 @@
-#pragma once
\ No newline at end of file
+#pragma once
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <atomic>
+#include <type_traits>
+#include "../Config.hpp"
+
+// Asynchronous binary logger.
+// log() captures the format string pointer (which lives in flash and
+// doubles as the message id), an esp_timer timestamp and up to
+// LOG_MAX_ARGS raw 32-bit arguments into a lock-free ring. A low-priority
+// task drains the ring and formats records on the serial port, or writes
+// them as binary frames for tools/log_decode.py to format against the
+// firmware ELF (LOG_OUTPUT_BINARY). The caller never waits on the UART;
+// when the ring is full the record is dropped and counted. The cycles
+// each call spends are measured and reported by /api/perf.
+//
+// Arguments may be integers, enums, pointers or C strings. Strings are
+// copied (truncated) into the record, so they may be temporaries.
+//
+// Use the per-module, per-level macros below rather than log() directly.
+// Levels above LOG_LEVEL_<MODULE> (Config.hpp) are discarded with
+// `if constexpr`, so disabled calls emit no code, evaluate no arguments
+// and leave no format string in the image. Enabled format strings are
+// plain literals, which the ESP32 already keeps in flash (.rodata/DROM).
+enum LOG_LEVEL : uint8_t {
+    LOG_LEVEL_NONE = 0,
+    LOG_LEVEL_ERROR,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_DEBUG
+};
+
+class SystemLogger {
+public:
+    // False when every module's level is LOG_LEVEL_NONE: no call writes a
+    // record, so there is nothing to drain
+    static constexpr bool ENABLED = LOG_LEVEL_APP > LOG_LEVEL_NONE || LOG_LEVEL_DISPLAY > LOG_LEVEL_NONE ||
+                                    LOG_LEVEL_WEB > LOG_LEVEL_NONE || LOG_LEVEL_STORAGE > LOG_LEVEL_NONE;
+
+    void init();
+
+    // Start the drain task; records logged before this are kept until the
+    // ring fills. Executor mode runs drain() as a job instead.
+    void start();
+
+    template <typename... Args>
+    void log(const char* format, Args... args) {
+        static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "too many log arguments");
+
+        uint32_t startCycles = ESP.getCycleCount();
+        Slot* slot = claim();
+        if (!slot) return;
+
+        Record* record = &slot->record;
+        record->timestampUs = esp_timer_get_time();
+        record->format = format;
+        record->core = xPortGetCoreID();
+        record->argCount = sizeof...(Args);
+        record->stringMask = 0;
+        record->stringUsed = 0;
+        encodeArgs(*record, 0, args...);
+
+        commit(slot, ESP.getCycleCount() - startCycles);
+    }
+
+    uint32_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+    uint32_t getLogged() const { return logged.load(std::memory_order_relaxed); }
+
+    // Cycles spent in log() by the caller, over records written
+    uint32_t getAvgCycles() const;
+    uint32_t getMaxCycles() const { return maxCycles.load(std::memory_order_relaxed); }
+
+    // Format and print all pending records (called by the drain task or
+    // job every LOG_DRAIN_PERIOD_MS)
+    void drain();
+
+private:
+    static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0, "log ring size must be a power of two");
+
+    // Written as-is in binary frames; tools/log_decode.py mirrors this layout
+    struct Record {
+        uint64_t timestampUs;
+        const char* format;
+        uint8_t core;
+        uint8_t argCount;
+        uint8_t stringMask;   // Bit i set: args[i] is an offset into strings
+        uint8_t stringUsed;
+        uint32_t args[LOG_MAX_ARGS];
+        char strings[LOG_STRING_BYTES];
+    };
+
+    struct Slot {
+        std::atomic<uint32_t> sequence;
+        Record record;
+    };
+
+    Slot slots[LOG_RING_SIZE];
+    std::atomic<uint32_t> enqueuePosition;
+    uint32_t dequeuePosition;   // Drain task only
+
+    std::atomic<uint32_t> dropped;
+    std::atomic<uint32_t> logged;
+    std::atomic<uint64_t> totalCycles;
+    std::atomic<uint32_t> maxCycles;
+
+    Slot* claim();
+    void commit(Slot* slot, uint32_t cycles);
+    void output(const Record& record);
+
+    static void encodeArgs(Record&, size_t) {}
+
+    template <typename T, typename... Rest>
+    static void encodeArgs(Record& record, size_t index, T value, Rest... rest) {
+        encode(record, index, value);
+        encodeArgs(record, index + 1, rest...);
+    }
+
+    static void encode(Record& record, size_t index, const char* text);
+    static void encode(Record& record, size_t index, char* text) { encode(record, index, (const char*)text); }
+
+    template <typename T>
+    static void encode(Record& record, size_t index, T value) {
+        static_assert(std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value,
+                      "log arguments must be integers, enums, pointers or C strings");
+        record.args[index] = (uint32_t)(uintptr_t)value;
+    }
+
+    static void drainTask(void* parameter);
+};
+
+extern SystemLogger systemLogger;
+
+#define LOG_AT(module, level, format, ...)                          \
+    do {                                                            \
+        if constexpr ((level) <= (LOG_LEVEL_##module)) {            \
+            systemLogger.log(format, ##__VA_ARGS__);                \
+        }                                                           \
+    } while (0)
+
+#define LOG_E(module, format, ...) LOG_AT(module, LOG_LEVEL_ERROR, format, ##__VA_ARGS__)
+#define LOG_W(module, format, ...) LOG_AT(module, LOG_LEVEL_WARN, format, ##__VA_ARGS__)
+#define LOG_I(module, format, ...) LOG_AT(module, LOG_LEVEL_INFO, format, ##__VA_ARGS__)
+#define LOG_D(module, format, ...) LOG_AT(module, LOG_LEVEL_DEBUG, format, ##__VA_ARGS__)
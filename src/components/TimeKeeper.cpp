@@ -1,4 +1,6 @@
 #include "TimeKeeper.hpp"
+#include "UlpProgram.hpp"
+#include "SystemLogger.hpp"
 #include "Config.hpp"
 
 #include <esp32/ulp.h>
@@ -9,43 +11,105 @@
 #include <driver/rtc_cntl.h>
 #include <driver/rtc_io.h>
 #include <soc/rtc.h>
+#include <soc/sens_reg.h>
+#include <esp_timer.h>
+#include <driver/gpio.h>
 
 
 // Power sense configuration
 #define POWER_SENSE_PIN GPIO_NUM_32  // RTC GPIO: HIGH = main power, LOW = battery
 
 // RTC memory shared with ULP (persists through deep sleep)
-RTC_DATA_ATTR uint32_t ulp_seconds = 0;
-RTC_DATA_ATTR uint32_t ulp_minutes = 0;
-RTC_DATA_ATTR uint32_t ulp_hours = 0;
+// Local seconds since 1970-01-01 in two 16-bit halves, the ULP being 16-bit
+RTC_DATA_ATTR uint32_t ulp_epoch_low = 0;
+RTC_DATA_ATTR uint32_t ulp_epoch_high = 0;
+
+// Fractional part of the period in 1/65536 slow clock cycles, and the
+// ULP's running sum of it
+RTC_DATA_ATTR uint32_t ulp_frac_step = 0;
+RTC_DATA_ATTR uint32_t ulp_frac_acc = 0;
+
+// ulp_ticks is bumped at the start of every run and ulp_tick_done set to
+// match at the end, so the CPU can tell when the epoch and the RTC slow
+// counter snapshot (low 32 bits, in two halves, for calibration) are
+// mid-update
+RTC_DATA_ATTR uint32_t ulp_ticks = 0;
+RTC_DATA_ATTR uint32_t ulp_tick_done = 0;
+RTC_DATA_ATTR uint32_t ulp_tick_rtc_low = 0;
+RTC_DATA_ATTR uint32_t ulp_tick_rtc_high = 0;
+
+// Last long-window calibration, kept through deep sleep so a wake does not
+// fall back to the short boot measurement (0 = none yet). Both in slow
+// clock cycles, 16.16 fixed point.
+RTC_DATA_ATTR static uint64_t savedCyclesPerSecondQ16 = 0;
+RTC_DATA_ATTR static int64_t savedOverheadQ16 = 0;   // Added to every period by the ULP's own run
+
+// Last power failure, timed from the falling edge and kept through deep
+// sleep for the next boot to report (all 0 = none since power-on)
+RTC_DATA_ATTR static uint32_t powerFailDebounceUs = 0;
+RTC_DATA_ATTR static uint32_t powerFailCallbackUs = 0;
+RTC_DATA_ATTR static uint32_t powerFailToSleepUs = 0;
+
+// A run takes tens of microseconds; wait out at most this many
+static constexpr int ULP_RUN_WAIT_US = 200;
+
+// How often the level is checked while debouncing a falling edge
+static constexpr uint32_t POWER_SAMPLE_US = 50;
+
+static_assert(ULP_TICK_SECONDS >= 1 && ULP_TICK_SECONDS <= 60, "ULP_TICK_SECONDS out of range");
+
+static uint16_t rtcWordOffset(const uint32_t* variable) {
+    return ((uint32_t)variable - SOC_RTC_DATA_LOW) / sizeof(uint32_t);
+}
 
-void TimeKeeper::init() {
-    // Configure power sense GPIO as RTC input
-    rtc_gpio_init(POWER_SENSE_PIN);
-    rtc_gpio_set_direction(POWER_SENSE_PIN, RTC_GPIO_MODE_INPUT_ONLY);
+// num / den in 16.16 fixed point without overflowing on long windows
+static uint64_t ratioQ16(uint64_t num, uint64_t den) {
+    uint64_t whole = num / den;
+    uint64_t remainder = num % den;
+    return (whole << 16) + (remainder << 16) / den;
+}
 
-    rtc_gpio_pulldown_en(POWER_SENSE_PIN);
-    gpio_pulldown_en(POWER_SENSE_PIN);
+// How far a ULP tick of `periodQ16` cycles is from one of `tickQ16`, the
+// cycles in ULP_TICK_SECONDS real seconds
+static int32_t driftPpb(uint64_t periodQ16, uint64_t tickQ16) {
+    return ((int64_t)periodQ16 - (int64_t)tickQ16) * 1000000000LL / (int64_t)tickQ16;
+}
 
-    // Only initialize time on first boot (not after waking from sleep)
-    // RTC memory persists through deep sleep, so time is already set if we woke up
+void TimeKeeper::init() {
+    powerLossCallback = nullptr;
+    powerTask = nullptr;
+    powerEdgeUs = 0;
+    powerGlitches = 0;
+    calibrationCount = 0;
+
+    // Power sense GPIO as a digital input while awake, for the edge
+    // interrupt; ext0 switches it back to the RTC mux for deep sleep, and
+    // the pulldown lives in the RTC pad either way
+    rtc_gpio_deinit(POWER_SENSE_PIN);
+    gpio_config_t config = {};
+    config.pin_bit_mask = 1ULL << POWER_SENSE_PIN;
+    config.mode = GPIO_MODE_INPUT;
+    config.pull_down_en = GPIO_PULLDOWN_ENABLE;
+    config.intr_type = GPIO_INTR_DISABLE;
+    gpio_config(&config);
+
+    // Only a deep-sleep wake keeps time. Every other reset (power-on, but
+    // also software, panic, watchdog and brownout) reloads RTC_DATA_ATTR
+    // from flash, clearing the epoch and the calibration, so it starts
+    // over like a cold boot.
     esp_reset_reason_t reset_reason = esp_reset_reason();
-    if (reset_reason == ESP_RST_POWERON) {
-        ulp_hours = 12;
-        ulp_minutes = 0;
-        ulp_seconds = 0;
+    bool resumed = reset_reason == ESP_RST_DEEPSLEEP;
+    if (!resumed) {
+        ulp_epoch_high = TIME_DEFAULT_EPOCH >> 16;
+        ulp_epoch_low = TIME_DEFAULT_EPOCH & 0xFFFF;
 #ifdef DEBUG_LEDSTACK
-        Serial.println("First boot - initializing time to 12:00:00");
+        Serial.printf("Cold boot (reset reason %d) - initializing time to epoch %u\n",
+                      reset_reason, (uint32_t)TIME_DEFAULT_EPOCH);
 #endif
-    } 
-#ifdef DEBUG_LEDSTACK
-    else {
-        Serial.printf("Resumed - Time preserved: %02d:%02d:%02d\n", ulp_hours, ulp_minutes, ulp_seconds);
     }
-#endif
 
 #ifdef DEBUG_LEDSTACK
-    int gpio_level = rtc_gpio_get_level(POWER_SENSE_PIN);
+    int gpio_level = gpio_get_level(POWER_SENSE_PIN);
     PowerStatus powerStatus = gpio_level ? MAIN_POWER : BATTERY_POWER;
 
     Serial.printf("GPIO 32 level: %d (0=LOW/battery, 1=HIGH/main)\n", gpio_level);
@@ -56,12 +120,19 @@ void TimeKeeper::init() {
     loadULPProgram();
 
 #ifdef DEBUG_LEDSTACK
+    if (resumed) {
+        Calendar::DateTime now = getDateTime();
+        Serial.printf("Resumed - Time preserved: %04d-%02d-%02d %02d:%02d:%02d\n",
+                      now.year, now.month, now.day, now.hour, now.minute, now.second);
+    }
     Serial.printf("TimeKeeper initialized - Power: %s\n", powerStatus == MAIN_POWER ? "MAIN" : "BATTERY");
 #endif
 }
 
 void TimeKeeper::configureWakeup() {
-    esp_sleep_enable_ulp_wakeup();
+    // The ULP only counts time; the power sense pin going HIGH wakes the
+    // CPU straight away whatever the ULP period
+    esp_sleep_enable_ext0_wakeup(POWER_SENSE_PIN, 1);
 }
 
 void TimeKeeper::loadULPProgram() {
@@ -69,102 +140,36 @@ void TimeKeeper::loadULPProgram() {
     Serial.println("Setting up ULP program for timekeeping and power monitoring...");
 #endif
 
-    // Calibrate RTC slow clock for better timekeeping accuracy
-    // This measures the actual RTC_SLOW_CLK frequency against the crystal
-    uint32_t calibrated_period = 1000000;  // Default: 1 second
-    uint32_t cal_value = rtc_clk_cal(RTC_CAL_RTC_MUX, 1000);
-
-    if (cal_value){
+    // Slow clock cycles per second: the long-window calibration kept from
+    // before deep sleep, otherwise a short measurement against the crystal.
+    // rtc_clk_cal() returns microseconds per slow clock cycle in Q13.19.
+    uint64_t cyclesPerSecondQ16 = savedCyclesPerSecondQ16;
+    if (!cyclesPerSecondQ16) {
+        uint32_t cal_value = rtc_clk_cal(RTC_CAL_RTC_MUX, RTC_CAL_BOOT_CYCLES);
+        cyclesPerSecondQ16 = cal_value ? (1000000ULL << 35) / cal_value : (150000ULL << 16);
+        savedCyclesPerSecondQ16 = cyclesPerSecondQ16;
 #ifdef DEBUG_LEDSTACK
         Serial.printf("RTC calibration value: %d\n", cal_value);
-        Serial.printf("Calibration represents: %d us per RTC clock cycle\n", cal_value >> 19);
-#endif
-        // cal_value is in Q13.19 fixed-point format (microseconds per RTC cycle * 2^19)
-        // To get 1 second (1000000 us), we need: cycles = 1000000 * 2^19 / cal_value
-        // Then convert cycles to microseconds for ulp_set_wakeup_period
-        // But ulp_set_wakeup_period expects microseconds, so we use cal_value directly
-
-        // For 1 second at actual RTC frequency:
-        // We want: 1000000 microseconds of real time
-        // The cal_value tells us how many microseconds each RTC cycle actually takes
-        // So we keep the period at 1000000 us - the RTC will handle the rest
-        calibrated_period = 1000000;  // Keep at 1 second - calibration is already factored in
-
-#ifdef DEBUG_LEDSTACK
-        Serial.printf("Using standard ULP timer period: %d us\n", calibrated_period);
-        Serial.printf("RTC calibration will be handled by hardware\n");
 #endif
     }
 
     // Calculate RTC_SLOW_MEM offsets for our variables
-    size_t addr_offset_seconds = ((uint32_t)&ulp_seconds - SOC_RTC_DATA_LOW) / sizeof(uint32_t);
-    size_t addr_offset_minutes = ((uint32_t)&ulp_minutes - SOC_RTC_DATA_LOW) / sizeof(uint32_t);
-    size_t addr_offset_hours = ((uint32_t)&ulp_hours - SOC_RTC_DATA_LOW) / sizeof(uint32_t);
+    UlpProgram::Variables variables;
+    variables.epochLow = rtcWordOffset(&ulp_epoch_low);
+    variables.epochHigh = rtcWordOffset(&ulp_epoch_high);
+    variables.fracStep = rtcWordOffset(&ulp_frac_step);
+    variables.fracAcc = rtcWordOffset(&ulp_frac_acc);
+    variables.ticks = rtcWordOffset(&ulp_ticks);
+    variables.tickDone = rtcWordOffset(&ulp_tick_done);
+    variables.tickRtcLow = rtcWordOffset(&ulp_tick_rtc_low);
+    variables.tickRtcHigh = rtcWordOffset(&ulp_tick_rtc_high);
 
 #ifdef DEBUG_LEDSTACK
-    Serial.printf("ULP memory offsets: seconds=%d, minutes=%d, hours=%d\n", addr_offset_seconds, addr_offset_minutes, addr_offset_hours);
+    Serial.printf("ULP memory offsets: epoch=%d/%d, ticks=%d\n", variables.epochLow, variables.epochHigh, variables.ticks);
 #endif
 
-    // ULP program (runs every 1 second during deep sleep):
-    // 1. Increment seconds counter
-    // 2. Handle minute/hour overflow
-    // 3. Read GPIO 32 to check power status
-    // 4. Wake CPU if main power detected
-    const ulp_insn_t ulp_program[] = {
-        // Increment seconds
-        I_MOVI(R1, addr_offset_seconds),
-        I_LD(R0, R1, 0),
-        I_ADDI(R0, R0, 1),
-        I_ST(R0, R1, 0),
-
-        // Check if seconds >= 60
-        M_BL(1, 60),          // Branch to label 1 if R0 < 60
-        // Seconds overflow: reset to 0 and increment minutes
-        I_MOVI(R0, 0),
-        I_MOVI(R1, addr_offset_seconds),
-        I_ST(R0, R1, 0),
-
-        // Increment minutes
-        I_MOVI(R1, addr_offset_minutes),
-        I_LD(R0, R1, 0),
-        I_ADDI(R0, R0, 1),
-        I_ST(R0, R1, 0),
-
-        // Check if minutes >= 60
-        M_BL(1, 60),          // Branch to label 1 if R0 < 60
-        // Minutes overflow: reset to 0 and increment hours
-        I_MOVI(R0, 0),
-        I_MOVI(R1, addr_offset_minutes),
-        I_ST(R0, R1, 0),
-
-        // Increment hours
-        I_MOVI(R1, addr_offset_hours),
-        I_LD(R0, R1, 0),
-        I_ADDI(R0, R0, 1),
-        I_ST(R0, R1, 0),
-
-        // Check if hours >= 24
-        M_BL(1, 24),          // Branch to label 1 if R0 < 24
-        // Hours overflow: reset to 0
-        I_MOVI(R0, 0),
-        I_MOVI(R1, addr_offset_hours),
-        I_ST(R0, R1, 0),
-
-        // Label 1: Check power status
-        M_LABEL(1),
-        // Read RTC GPIO 9 (GPIO 32) state into R0
-        I_RD_REG(RTC_GPIO_IN_REG, RTC_GPIO_IN_NEXT_S + 9, RTC_GPIO_IN_NEXT_S + 9),
-
-        // If GPIO HIGH (main power), wake the CPU
-        M_BL(2, 1),           // Branch to label 2 if R0 < 1 (battery)
-        I_WAKE(),             // Main power detected - wake CPU!
-        I_HALT(),
-
-        M_LABEL(2),           // Battery power - stay asleep
-        I_HALT()
-    };
-
-    size_t program_size = sizeof(ulp_program) / sizeof(ulp_insn_t);
+    ulp_insn_t ulp_program[UlpProgram::MAX_INSTRUCTIONS];
+    size_t program_size = UlpProgram::build(variables, ULP_TICK_SECONDS, ulp_program);
 
 #ifdef DEBUG_LEDSTACK
     Serial.printf("ULP program size: %d instructions\n", program_size);
@@ -182,11 +187,12 @@ void TimeKeeper::loadULPProgram() {
     Serial.printf("ULP program loaded successfully, final size: %d\n", program_size);
 #endif
 
-    // Configure ULP wakeup timer with calibrated period for accurate timekeeping
-    ulp_set_wakeup_period(0, calibrated_period);
+    // Sleep for a tick of slow clock, less what each run adds
+    programPeriod(cyclesPerSecondQ16 * ULP_TICK_SECONDS - savedOverheadQ16);
 
 #ifdef DEBUG_LEDSTACK
-    Serial.printf("ULP timer configured with calibrated period (%d us)\n", calibrated_period);
+    Serial.printf("ULP timer configured for %u + %u/65536 slow clock cycles\n",
+                  (uint32_t)(programmedQ16 >> 16), (uint32_t)(programmedQ16 & 0xFFFF));
 #endif
 
     // Start the ULP program (sets entry point to address 0)
@@ -199,34 +205,278 @@ void TimeKeeper::loadULPProgram() {
     }
 #ifdef DEBUG_LEDSTACK
     Serial.println("ULP program started successfully");
-    Serial.println("ULP will wake CPU automatically when GPIO 32 goes HIGH (main power restored)");
+    Serial.printf("ULP counts %d s per tick; GPIO 32 going HIGH wakes the CPU\n", ULP_TICK_SECONDS);
 #endif
+
+    // The first calibration window opens at the new program's first tick
+    windowStarted = false;
+    windowStartTick = readTickSnapshot();
+}
+
+void TimeKeeper::programPeriod(uint64_t cyclesQ16) {
+    uint32_t cycles = cyclesQ16 >> 16;
+    REG_SET_FIELD(SENS_ULP_CP_SLEEP_CYC0_REG, SENS_SLEEP_CYCLES_S0, cycles);
+    REG_SET_FIELD(SENS_ULP_CP_SLEEP_CYC1_REG, SENS_SLEEP_CYCLES_S1, cycles + 1);
+    ulp_frac_step = cyclesQ16 & 0xFFFF;
+    programmedQ16 = cyclesQ16;
+}
+
+TimeKeeper::TickSnapshot TimeKeeper::readTickSnapshot() {
+    // The ULP only stores the low 16 bits of each word
+    TickSnapshot snapshot;
+    for (int waited = 0; waited < ULP_RUN_WAIT_US; waited++) {
+        uint16_t done = ulp_tick_done & 0xFFFF;
+        snapshot.rtcCycles = ((ulp_tick_rtc_high & 0xFFFF) << 16) | (ulp_tick_rtc_low & 0xFFFF);
+        snapshot.ticks = ulp_ticks & 0xFFFF;
+        if (snapshot.ticks == done) break;
+        delayMicroseconds(1);
+    }
+    return snapshot;
+}
+
+void TimeKeeper::startCalibrationWindow() {
+    windowStartUs = esp_timer_get_time();
+    windowStartRtc = rtc_time_get();
+    windowStartTick = readTickSnapshot();
+    windowStarted = true;
+}
+
+void TimeKeeper::updateCalibration() {
+    if (!windowStarted) {
+        if (readTickSnapshot().ticks != windowStartTick.ticks) {
+            startCalibrationWindow();
+        }
+        return;
+    }
+
+    int64_t nowUs = esp_timer_get_time();
+    int64_t elapsedUs = nowUs - windowStartUs;
+    if (elapsedUs < (int64_t)RTC_CAL_INTERVAL_S * 1000000) {
+        return;
+    }
+
+    // The slow clock against the crystal, over the whole window
+    uint64_t rtcCycles = rtc_time_get() - windowStartRtc;
+    uint64_t cyclesPerSecondQ16 = ratioQ16(rtcCycles * 1000000, elapsedUs);
+
+    // The period the ULP actually kept, from the slow counter it recorded
+    // at each end of the window; sleep plus its own run time
+    TickSnapshot tick = readTickSnapshot();
+    uint16_t ticks = tick.ticks - windowStartTick.ticks;
+    uint64_t periodQ16 = ticks ? ratioQ16((uint32_t)(tick.rtcCycles - windowStartTick.rtcCycles), ticks) : 0;
+
+    // Predicted: what the programmed period and the overhead estimate
+    // come to at this window's clock rate. Measured: what the ULP did.
+    uint64_t tickQ16 = cyclesPerSecondQ16 * ULP_TICK_SECONDS;
+    int32_t predictedPpb = driftPpb(programmedQ16 + savedOverheadQ16, tickQ16);
+    int32_t measuredPpb = driftPpb(periodQ16, tickQ16);
+
+    int64_t overheadQ16 = (int64_t)periodQ16 - (int64_t)programmedQ16;
+    if (ticks && overheadQ16 > -(int64_t)(programmedQ16 >> 6) && overheadQ16 < (int64_t)(programmedQ16 >> 6)) {
+        savedOverheadQ16 = overheadQ16;
+        LOG_I(APP, "RTC cal: slow clock %u mHz, drift predicted %d ppb, measured %d ppb over %u ticks",
+              (uint32_t)((cyclesPerSecondQ16 * 1000) >> 16), predictedPpb, measuredPpb, ticks);
+    } else {
+        // No ticks, or a snapshot off by more than 1/64: keep the old overhead
+        LOG_W(APP, "RTC cal: slow clock %u mHz, drift predicted %d ppb, ULP ticks unusable (%u)",
+              (uint32_t)((cyclesPerSecondQ16 * 1000) >> 16), predictedPpb, ticks);
+    }
+
+    savedCyclesPerSecondQ16 = cyclesPerSecondQ16;
+    programPeriod(tickQ16 - savedOverheadQ16);
+    calibrationCount++;
+    startCalibrationWindow();
+}
+
+uint32_t TimeKeeper::getSlowClockMilliHz() {
+    return (savedCyclesPerSecondQ16 * 1000) >> 16;
+}
+
+uint32_t TimeKeeper::secondsSinceTick(uint32_t tickRtcCycles) {
+    // Not calibrated yet (before loadULPProgram())
+    if (savedCyclesPerSecondQ16 == 0) return 0;
+
+    uint32_t cycles = (uint32_t)rtc_time_get() - tickRtcCycles;
+    uint64_t seconds = ((uint64_t)cycles << 16) / savedCyclesPerSecondQ16;
+
+    // A tick may run a little late; much later means the snapshot is stale
+    // (no tick yet, or a latch that failed) and says nothing
+    if (seconds >= 2 * ULP_TICK_SECONDS) return 0;
+    return seconds < ULP_TICK_SECONDS ? seconds : ULP_TICK_SECONDS - 1;
+}
+
+uint32_t TimeKeeper::getEpoch() {
+    // Consistent when no run started between reading ulp_tick_done and
+    // ulp_ticks; otherwise wait for the run to finish
+    uint32_t epoch = 0;
+    uint32_t tickRtc = 0;
+    for (int waited = 0; waited < ULP_RUN_WAIT_US; waited++) {
+        uint16_t done = ulp_tick_done & 0xFFFF;
+        epoch = ((ulp_epoch_high & 0xFFFF) << 16) | (ulp_epoch_low & 0xFFFF);
+        tickRtc = ((ulp_tick_rtc_high & 0xFFFF) << 16) | (ulp_tick_rtc_low & 0xFFFF);
+        if ((ulp_ticks & 0xFFFF) == done) break;
+        delayMicroseconds(1);
+    }
+
+    // The ULP counts whole ticks; add the seconds since the last one
+    return epoch + secondsSinceTick(tickRtc);
+}
+
+void TimeKeeper::setEpoch(uint32_t epochSeconds) {
+    // Write between runs, backdated to the last tick. A run that starts
+    // meanwhile may already have loaded the old low half and store it
+    // back incremented, so write again once it is done.
+    for (int waited = 0; waited < ULP_RUN_WAIT_US; waited++) {
+        uint16_t ticks = ulp_ticks & 0xFFFF;
+        if ((ulp_tick_done & 0xFFFF) == ticks) {
+            uint32_t tickRtc = ((ulp_tick_rtc_high & 0xFFFF) << 16) | (ulp_tick_rtc_low & 0xFFFF);
+            uint32_t epoch = epochSeconds - secondsSinceTick(tickRtc);
+            ulp_epoch_high = epoch >> 16;
+            ulp_epoch_low = epoch & 0xFFFF;
+            if ((ulp_ticks & 0xFFFF) == ticks) return;
+        }
+        delayMicroseconds(1);
+    }
+}
+
+uint32_t TimeKeeper::getAwakeUsPerTick() {
+    // The overhead calibration measures is the ULP's time awake per tick
+    if (calibrationCount == 0 || savedOverheadQ16 <= 0 || savedCyclesPerSecondQ16 == 0) {
+        return ULP_AWAKE_ESTIMATE_US;
+    }
+    return (uint32_t)((uint64_t)savedOverheadQ16 * 1000000 / savedCyclesPerSecondQ16);
+}
+
+uint32_t TimeKeeper::estimateSleepCurrentNa(uint32_t tickSeconds) {
+    // uA * us per s is pA
+    return SLEEP_BASE_CURRENT_NA + ULP_ACTIVE_CURRENT_UA * getAwakeUsPerTick() / (tickSeconds * 1000);
+}
+
+Calendar::DateTime TimeKeeper::getDateTime() {
+    return Calendar::fromEpoch(getEpoch());
 }
 
 TimeData TimeKeeper::getCurrentTime() {
+    Calendar::DateTime now = getDateTime();
     TimeData time;
-    time.hour = ulp_hours;
-    time.minute = ulp_minutes;
-    time.second = ulp_seconds;
+    time.hour = now.hour;
+    time.minute = now.minute;
+    time.second = now.second;
     return time;
 }
 
 void TimeKeeper::setTime(uint8_t h, uint8_t m, uint8_t s) {
-    ulp_hours = h;
-    ulp_minutes = m;
-    ulp_seconds = s;
+    // Keep the date
+    uint32_t epoch = getEpoch();
+    setEpoch(epoch - epoch % 86400 + h * 3600 + m * 60 + s);
 }
 
 PowerStatus TimeKeeper::getPowerStatus() {
     // Read GPIO 32 directly to get current power status
-    int gpio_level = rtc_gpio_get_level(POWER_SENSE_PIN);
-    return gpio_level ? MAIN_POWER : BATTERY_POWER;
+    return gpio_get_level(POWER_SENSE_PIN) ? MAIN_POWER : BATTERY_POWER;
+}
+
+void TimeKeeper::startPowerMonitor() {
+    if (powerTask) {
+        return;
+    }
+
+    // ISR service first, so a failure leaves no task behind. Arduino may
+    // have installed it already.
+    esp_err_t err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        LOG_E(APP, "Power monitor: ISR service failed (%d)", err);
+        return;
+    }
+
+    // The handler notifies this task, so it exists before the handler is added
+    if (xTaskCreatePinnedToCore(
+            powerTaskEntry,
+            "PowerTask",
+            4096,
+            this,
+            POWER_FAIL_TASK_PRIORITY,
+            &powerTask,
+            0) != pdPASS) {
+        powerTask = nullptr;
+        LOG_E(APP, "Power monitor: task creation failed");
+        return;
+    }
+    gpio_set_intr_type(POWER_SENSE_PIN, GPIO_INTR_NEGEDGE);
+    gpio_isr_handler_add(POWER_SENSE_PIN, powerEdgeIsr, this);
+
+    // A drop before the interrupt was enabled has no edge left to catch
+    if (getPowerStatus() == BATTERY_POWER) {
+        powerEdgeUs = (uint32_t)esp_timer_get_time();
+        xTaskNotifyGive(powerTask);
+    }
+}
+
+void IRAM_ATTR TimeKeeper::powerEdgeIsr(void* parameter) {
+    TimeKeeper* self = static_cast<TimeKeeper*>(parameter);
+    BaseType_t woken = pdFALSE;
+    self->powerEdgeUs = (uint32_t)esp_timer_get_time();
+    vTaskNotifyGiveFromISR(self->powerTask, &woken);
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+void TimeKeeper::powerTaskEntry(void* parameter) {
+    TimeKeeper* self = static_cast<TimeKeeper*>(parameter);
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // Main power is gone only if the line stays LOW for the whole
+        // debounce window; a later edge restarts the window
+        bool dropped = true;
+        while ((uint32_t)esp_timer_get_time() - self->powerEdgeUs < POWER_FAIL_DEBOUNCE_US) {
+            if (self->getPowerStatus() == MAIN_POWER) {
+                dropped = false;
+                break;
+            }
+            delayMicroseconds(POWER_SAMPLE_US);
+        }
+        if (!dropped) {
+            self->powerGlitches++;
+            continue;
+        }
+        self->sleepAfterPowerFail(self->powerEdgeUs);
+    }
+}
+
+void TimeKeeper::sleepAfterPowerFail(uint32_t edgeUs) {
+    uint32_t confirmedUs = esp_timer_get_time();
+
+    // Give dependants a chance to flush state before we go to sleep
+    if (powerLossCallback) {
+        powerLossCallback();
+    }
+    uint32_t flushedUs = esp_timer_get_time();
+
+    powerFailDebounceUs = confirmedUs - edgeUs;
+    powerFailCallbackUs = flushedUs - confirmedUs;
+    powerFailToSleepUs = (uint32_t)esp_timer_get_time() - edgeUs;
+    esp_deep_sleep_start();
+}
+
+TimeKeeper::PowerFailTiming TimeKeeper::getLastPowerFail() {
+    PowerFailTiming timing;
+    timing.debounceUs = powerFailDebounceUs;
+    timing.callbackUs = powerFailCallbackUs;
+    timing.toSleepUs = powerFailToSleepUs;
+    return timing;
+}
+
+void TimeKeeper::setPowerLossCallback(void (*callback)()) {
+    powerLossCallback = callback;
 }
 
 void TimeKeeper::enterDeepSleep() {
 #ifdef DEBUG_LEDSTACK
     Serial.println("Entering deep sleep...");
-    Serial.println("ULP will monitor GPIO 32 and wake when main power is restored");
+    Serial.println("GPIO 32 going HIGH (ext0) wakes the CPU when main power is restored");
     Serial.flush();
 #endif
 
@@ -239,6 +489,6 @@ void TimeKeeper::enterDeepSleep() {
 #endif
 }
 
-bool TimeKeeper::wasWokenByULP() {
-    return esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_ULP;
+bool TimeKeeper::wasWokenByPowerRestore() {
+    return esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_EXT0;
 }
@@ -2,7 +2,10 @@
 #include <driver/rtc_io.h>
 #include <esp32/ulp.h>
 #include <esp_sleep.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include "Types.hpp"
+#include "Calendar.hpp"
 
 class TimeKeeper {
 public:
@@ -10,15 +13,84 @@ public:
     void loadULPProgram();
     TimeData getCurrentTime();
     void setTime(uint8_t h, uint8_t m, uint8_t s);
+
+    // Local seconds since 1970-01-01 as counted by the ULP, plus the
+    // seconds since its last tick
+    uint32_t getEpoch();
+    void setEpoch(uint32_t epochSeconds);
+    Calendar::DateTime getDateTime();
     PowerStatus getPowerStatus();
     void enterDeepSleep();
-    bool wasWokenByULP();
+    bool wasWokenByPowerRestore();
+
+    // Last power failure: falling edge to confirmed, time spent in the
+    // power loss callback, and falling edge to esp_deep_sleep_start()
+    struct PowerFailTiming {
+        uint32_t debounceUs;
+        uint32_t callbackUs;
+        uint32_t toSleepUs;
+    };
+
+    // Called on a confirmed power failure, right before deep sleep
+    void setPowerLossCallback(void (*callback)());
+
+    // Watch the power sense pin from its falling edge interrupt. A drop
+    // that holds for POWER_FAIL_DEBOUNCE_US runs the power loss callback
+    // and enters deep sleep from a high-priority task; shorter dips are
+    // counted as glitches.
+    void startPowerMonitor();
+    uint32_t getPowerGlitches() { return powerGlitches; }
+
+    // Kept through deep sleep; all 0 until the first power failure
+    PowerFailTiming getLastPowerFail();
+
+    // Call periodically while awake. Every RTC_CAL_INTERVAL_S, measures the
+    // slow clock and the ULP's real period against the crystal, logs the
+    // drift and reprograms the ULP period.
+    void updateCalibration();
+
+    // Slow clock frequency in use, in mHz
+    uint32_t getSlowClockMilliHz();
+    uint32_t getCalibrationCount() { return calibrationCount; }
+
+    // ULP time awake per tick (measured once calibrated), and the average
+    // deep-sleep current it would come to at a given ULP_TICK_SECONDS
+    uint32_t getAwakeUsPerTick();
+    uint32_t estimateSleepCurrentNa(uint32_t tickSeconds);
 
 private:
+    // Last ULP tick: tick count and the low 32 bits of the RTC slow counter
+    struct TickSnapshot {
+        uint16_t ticks;
+        uint32_t rtcCycles;
+    };
+
     void configureWakeup();
+
+    // Set the ULP period to `cyclesQ16` slow clock cycles (16.16 fixed point)
+    void programPeriod(uint64_t cyclesQ16);
+    TickSnapshot readTickSnapshot();
+    uint32_t secondsSinceTick(uint32_t tickRtcCycles);
+    void startCalibrationWindow();
+
+    void (*powerLossCallback)();
+    TaskHandle_t powerTask;
+    volatile uint32_t powerEdgeUs;  // Low half of esp_timer at the last falling edge
+    volatile uint32_t powerGlitches;
+
+    static void powerEdgeIsr(void* parameter);
+    static void powerTaskEntry(void* parameter);
+    void sleepAfterPowerFail(uint32_t edgeUs);
+
+    // Calibration window, restarted after every recalibration
+    bool windowStarted;
+    int64_t windowStartUs;
+    uint64_t windowStartRtc;
+    TickSnapshot windowStartTick;
+    uint64_t programmedQ16;     // Sleep cycles per tick as programmed
+    uint32_t calibrationCount;
 };
 
-extern RTC_DATA_ATTR uint32_t ulp_seconds;
-extern RTC_DATA_ATTR uint32_t ulp_minutes;
-extern RTC_DATA_ATTR uint32_t ulp_hours;
+extern RTC_DATA_ATTR uint32_t ulp_epoch_low;
+extern RTC_DATA_ATTR uint32_t ulp_epoch_high;
 extern RTC_DATA_ATTR uint32_t ulp_power_status;
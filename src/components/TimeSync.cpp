@@ -0,0 +1,316 @@
+#include "TimeSync.hpp"
+#include "SystemLogger.hpp"
+#include <esp_timer.h>
+#include <esp_system.h>
+#include <lwip/sockets.h>
+#include <string.h>
+
+static constexpr int64_t US_PER_DAY = 86400LL * 1000000;
+
+// Seconds from 1900-01-01 (NTP era 0) to 1970-01-01
+static constexpr int64_t NTP_UNIX_OFFSET_S = 2208988800LL;
+static constexpr size_t NTP_PACKET_SIZE = 48;
+
+static uint32_t readBigEndian32(const uint8_t* in) {
+    return ((uint32_t)in[0] << 24) | ((uint32_t)in[1] << 16) | ((uint32_t)in[2] << 8) | in[3];
+}
+
+// 64-bit NTP timestamp to local microseconds since 1970
+static int64_t ntpToLocalUs(const uint8_t* in) {
+    int64_t seconds = readBigEndian32(in);
+    uint32_t fraction = readBigEndian32(in + 4);
+
+    // Era 1 starts in 2036; small values there are past 2036, not 1900
+    if (seconds < 0x80000000LL) seconds += 0x100000000LL;
+
+    return (seconds - NTP_UNIX_OFFSET_S + TIME_SYNC_UTC_OFFSET_S) * 1000000 +
+           (int64_t)(((uint64_t)fraction * 1000000) >> 32);
+}
+
+static uint32_t secondsOfDay(const TimeData& time) {
+    return time.hour * 3600 + time.minute * 60 + time.second;
+}
+
+void TimeSync::init(uint32_t seedEpoch) {
+    lock = portMUX_INITIALIZER_UNLOCKED;
+    int64_t monotonic = esp_timer_get_time();
+    offsetUs = (int64_t)seedEpoch * 1000000 - monotonic;
+    slewRemainingUs = 0;
+    lastSlewUs = monotonic;
+    firstSyncUs = 0;
+    lastSyncUs = 0;
+    clearSamples();
+
+    memset(&stats, 0, sizeof(stats));
+    stats.source = TIME_SOURCE_NONE;
+
+    sntpServer = nullptr;
+    sntpIntervalS = 0;
+    sntpTask = nullptr;
+}
+
+int64_t TimeSync::advance(int64_t monotonicUs) {
+    if (slewRemainingUs == 0) {
+        lastSlewUs = monotonicUs;
+        return monotonicUs + offsetUs;
+    }
+
+    // Leave lastSlewUs alone until at least 1 us is due, so frequent
+    // reads do not round the slew away
+    int64_t budget = (monotonicUs - lastSlewUs) * TIME_SYNC_SLEW_PPM / 1000000;
+    if (budget > 0) {
+        int64_t step = slewRemainingUs > 0 ? (slewRemainingUs < budget ? slewRemainingUs : budget)
+                                           : (slewRemainingUs > -budget ? slewRemainingUs : -budget);
+        offsetUs += step;
+        slewRemainingUs -= step;
+        lastSlewUs = monotonicUs;
+    }
+    return monotonicUs + offsetUs;
+}
+
+int64_t TimeSync::nowUs() {
+    int64_t monotonic = esp_timer_get_time();
+    taskENTER_CRITICAL(&lock);
+    int64_t now = advance(monotonic);
+    taskEXIT_CRITICAL(&lock);
+    return now;
+}
+
+TimeData TimeSync::getTimeOfDay() {
+    int64_t microseconds = nowUs() % US_PER_DAY;
+    if (microseconds < 0) microseconds += US_PER_DAY;
+
+    uint32_t seconds = microseconds / 1000000;
+    TimeData time;
+    time.hour = seconds / 3600;
+    time.minute = (seconds / 60) % 60;
+    time.second = seconds % 60;
+    return time;
+}
+
+void TimeSync::setTimeOfDay(uint8_t hour, uint8_t minute, uint8_t second) {
+    TimeData time = { hour, minute, second };
+    int64_t monotonic = esp_timer_get_time();
+
+    taskENTER_CRITICAL(&lock);
+    // Keep the date, replace the time of day
+    int64_t now = advance(monotonic);
+    int64_t midnight = now - ((now % US_PER_DAY) + US_PER_DAY) % US_PER_DAY;
+    offsetUs = midnight + (int64_t)secondsOfDay(time) * 1000000 - monotonic;
+    slewRemainingUs = 0;
+    firstSyncUs = monotonic;
+    lastSyncUs = monotonic;
+    clearSamples();
+
+    stats.synced = true;
+    stats.source = TIME_SOURCE_MANUAL;
+    stats.steps++;
+    stats.totalCorrectionUs = 0;
+    taskEXIT_CRITICAL(&lock);
+}
+
+void TimeSync::addClientExchange(int64_t t0, int64_t t1, int64_t t2, int64_t t3, TIME_SOURCE source) {
+    addSample(((t1 - t0) + (t2 - t3)) / 2, (t3 - t0) - (t2 - t1), source);
+}
+
+void TimeSync::addServerExchange(int64_t t0, int64_t t1, int64_t t2, int64_t t3, TIME_SOURCE source) {
+    addSample(((t0 - t1) + (t3 - t2)) / 2, (t3 - t0) - (t2 - t1), source);
+}
+
+void TimeSync::clearSamples() {
+    sampleCount = 0;
+    sampleNext = 0;
+}
+
+void TimeSync::correct(int64_t correctionUs, bool step) {
+    if (step) {
+        offsetUs += correctionUs;
+        slewRemainingUs = 0;
+        stats.steps++;
+    } else {
+        // Replaces any slew in progress: the new offset was measured
+        // against the clock with that slew only partly applied
+        slewRemainingUs = correctionUs;
+        stats.slews++;
+    }
+
+    // Kept samples now describe the corrected clock
+    for (size_t i = 0; i < sampleCount; i++) {
+        samples[i].offsetUs -= correctionUs;
+    }
+}
+
+void TimeSync::addSample(int64_t offset, int64_t delay, TIME_SOURCE source) {
+    int64_t monotonic = esp_timer_get_time();
+
+    taskENTER_CRITICAL(&lock);
+
+    // Millisecond browser timestamps can make a fast exchange look slightly negative
+    if (delay < -2000 || delay > (int64_t)TIME_SYNC_MAX_DELAY_MS * 1000) {
+        stats.samplesRejected++;
+        taskEXIT_CRITICAL(&lock);
+        return;
+    }
+    if (delay < 0) delay = 0;
+    stats.samplesAccepted++;
+
+    samples[sampleNext] = { offset, (uint32_t)delay, source, false };
+    sampleNext = (sampleNext + 1) % TIME_SYNC_FILTER_SIZE;
+    if (sampleCount < TIME_SYNC_FILTER_SIZE) sampleCount++;
+
+    // Clock filter: trust the lowest-delay sample, and each sample only once
+    Sample* best = &samples[0];
+    for (size_t i = 1; i < sampleCount; i++) {
+        if (samples[i].delayUs < best->delayUs) best = &samples[i];
+    }
+    if (best->used) {
+        taskEXIT_CRITICAL(&lock);
+        return;
+    }
+    best->used = true;
+
+    advance(monotonic);
+    int64_t correction = best->offsetUs;
+    int64_t magnitude = correction < 0 ? -correction : correction;
+    stats.lastOffsetUs = correction;
+    stats.lastDelayUs = best->delayUs;
+    stats.source = best->source;
+    lastSyncUs = monotonic;
+
+    if (!stats.synced) {
+        // First sync: any error is the unknown boot time, so step
+        if (magnitude >= (int64_t)TIME_SYNC_DEADBAND_MS * 1000) correct(correction, true);
+        stats.synced = true;
+        stats.totalCorrectionUs = 0;
+        firstSyncUs = monotonic;
+    } else if (magnitude >= (int64_t)TIME_SYNC_DEADBAND_MS * 1000) {
+        // A step is a discontinuity (a lost sync, a wrong reference), not
+        // something the local clock's rate explains, so only slews count
+        bool step = magnitude >= (int64_t)TIME_SYNC_STEP_MS * 1000;
+        correct(correction, step);
+        if (!step) stats.totalCorrectionUs += correction;
+    }
+
+    taskEXIT_CRITICAL(&lock);
+}
+
+uint32_t TimeSync::getEpoch() {
+    int64_t now = nowUs();
+    return now > 0 ? now / 1000000 : 0;
+}
+
+bool TimeSync::checkUlpTime(uint32_t ulpEpoch, uint32_t& corrected) {
+    uint32_t now = getEpoch();
+
+    // The ULP ticks at its own phase, so one second apart is normal
+    int64_t difference = (int64_t)ulpEpoch - now;
+    if (difference >= -1 && difference <= 1) {
+        return false;
+    }
+
+    corrected = now;
+    taskENTER_CRITICAL(&lock);
+    stats.ulpCorrections++;
+    taskEXIT_CRITICAL(&lock);
+    return true;
+}
+
+TimeSync::Stats TimeSync::getStats() {
+    int64_t monotonic = esp_timer_get_time();
+
+    taskENTER_CRITICAL(&lock);
+    advance(monotonic);
+    Stats result = stats;
+    result.slewRemainingUs = slewRemainingUs;
+    result.lastSyncAgeS = lastSyncUs ? (monotonic - lastSyncUs) / 1000000 : 0;
+
+    // Corrections needed per unit of time since the first sync; only
+    // meaningful after a while. The slews add at most TIME_SYNC_SLEW_PPM,
+    // so the product below stays far from overflowing.
+    int64_t elapsed = monotonic - firstSyncUs;
+    if (firstSyncUs && elapsed >= 60LL * 1000000) {
+        int64_t ppb = stats.totalCorrectionUs * 1000000 / (elapsed / 1000);
+        result.driftPpb = ppb > INT32_MAX ? INT32_MAX : ppb < INT32_MIN ? INT32_MIN : (int32_t)ppb;
+    } else {
+        result.driftPpb = 0;
+    }
+    taskEXIT_CRITICAL(&lock);
+    return result;
+}
+
+void TimeSync::startSntp(const char* server, uint32_t intervalS) {
+    if (!server || !server[0] || sntpTask) {
+        return;
+    }
+    sntpServer = server;
+    sntpIntervalS = intervalS;
+
+    xTaskCreatePinnedToCore(
+        sntpTaskEntry,
+        "SntpTask",
+        3072,
+        this,
+        1,
+        &sntpTask,
+        0
+    );
+}
+
+void TimeSync::sntpTaskEntry(void* parameter) {
+    TimeSync* self = static_cast<TimeSync*>(parameter);
+
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    timeval timeout = { 1, 0 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    for (;;) {
+        if (!self->pollSntp(sock)) {
+            taskENTER_CRITICAL(&self->lock);
+            self->stats.samplesRejected++;
+            taskEXIT_CRITICAL(&self->lock);
+            LOG_W(APP, "SNTP: no valid reply from %s", self->sntpServer);
+        }
+        vTaskDelay(pdMS_TO_TICKS(self->sntpIntervalS * 1000));
+    }
+}
+
+bool TimeSync::pollSntp(int sock) {
+    sockaddr_in server = {};
+    server.sin_family = AF_INET;
+    server.sin_port = htons(123);
+    if (sock < 0 || inet_aton(sntpServer, &server.sin_addr) == 0) {
+        return false;
+    }
+
+    // LI 0, version 4, mode 3 (client). The transmit timestamp is a nonce
+    // the server has to echo back as the originate timestamp.
+    uint8_t request[NTP_PACKET_SIZE] = {};
+    request[0] = (4 << 3) | 3;
+    uint32_t nonce[2] = { esp_random(), esp_random() };
+    memcpy(request + 40, nonce, sizeof(nonce));
+
+    // Drop late replies to an earlier poll
+    uint8_t reply[NTP_PACKET_SIZE + 16];
+    while (recv(sock, reply, sizeof(reply), MSG_DONTWAIT) > 0) {}
+
+    int64_t t0 = nowUs();
+    if (sendto(sock, request, sizeof(request), 0, (sockaddr*)&server, sizeof(server)) != (int)sizeof(request)) {
+        return false;
+    }
+    int received = recv(sock, reply, sizeof(reply), 0);
+    int64_t t3 = nowUs();
+
+    if (received < (int)NTP_PACKET_SIZE) {
+        return false;
+    }
+    uint8_t leap = reply[0] >> 6;
+    uint8_t mode = reply[0] & 0x07;
+    uint8_t stratum = reply[1];
+    if (mode != 4 || leap == 3 || stratum == 0 || stratum > 15 ||
+        memcmp(reply + 24, request + 40, 8) != 0) {
+        return false;
+    }
+
+    addClientExchange(t0, ntpToLocalUs(reply + 32), ntpToLocalUs(reply + 40), t3, TIME_SOURCE_SNTP);
+    return true;
+}
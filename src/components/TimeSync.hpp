@@ -0,0 +1,107 @@
+#pragma once
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <stdint.h>
+#include "../Types.hpp"
+
+enum TIME_SOURCE : uint8_t {
+    TIME_SOURCE_NONE,       // Seeded from the ULP counters at boot
+    TIME_SOURCE_MANUAL,     // Whole seconds set by hand (hour/minute/second)
+    TIME_SOURCE_BROWSER,    // NTP-style exchange with the control page
+    TIME_SOURCE_SNTP        // LAN SNTP server
+};
+
+// Wall clock disciplined like an NTP client.
+// Local time is esp_timer (crystal, microseconds since boot) plus an offset.
+// Each sample is one request/response exchange with a reference clock,
+// reduced to an offset and a round-trip delay. The last
+// TIME_SYNC_FILTER_SIZE samples are kept and only the one with the lowest
+// delay is trusted, since queueing on the network and in the server only
+// ever adds delay and skews the offset. Offsets under TIME_SYNC_DEADBAND_MS
+// are ignored, up to TIME_SYNC_STEP_MS they are slewed at
+// TIME_SYNC_SLEW_PPM so the clock never jumps, larger ones are stepped.
+//
+// Times are local (time zone applied) microseconds since 1970-01-01. Safe
+// to call from any task.
+class TimeSync {
+public:
+    struct Stats {
+        bool synced;
+        TIME_SOURCE source;         // Of the last sample that was used
+        uint32_t samplesAccepted;
+        uint32_t samplesRejected;   // Delay over TIME_SYNC_MAX_DELAY_MS or malformed
+        uint32_t steps;
+        uint32_t slews;
+        int64_t lastOffsetUs;       // Offset of the last used sample (reference - local)
+        uint32_t lastDelayUs;
+        int64_t slewRemainingUs;    // Correction still being slewed in
+        int64_t totalCorrectionUs;  // Sum of slewed corrections since the first sync
+        int32_t driftPpb;           // Local clock rate error implied by the slews
+        uint32_t lastSyncAgeS;
+        uint32_t ulpCorrections;    // Times the ULP counters had to be rewritten
+    };
+
+    // Start from the ULP's epoch
+    void init(uint32_t seedEpoch);
+
+    // Current local time
+    int64_t nowUs();
+    uint32_t getEpoch();
+    TimeData getTimeOfDay();
+
+    // Set whole seconds by hand; clears the filter
+    void setTimeOfDay(uint8_t hour, uint8_t minute, uint8_t second);
+
+    // An exchange where this device is the client: t0 local send, t1/t2
+    // reference receive/send, t3 local receive (SNTP)
+    void addClientExchange(int64_t t0, int64_t t1, int64_t t2, int64_t t3, TIME_SOURCE source);
+
+    // An exchange where this device answered: t0 reference send, t1/t2
+    // local receive/send, t3 reference receive (browser)
+    void addServerExchange(int64_t t0, int64_t t1, int64_t t2, int64_t t3, TIME_SOURCE source);
+
+    // Called with the ULP's epoch; true (with `corrected` filled) if it is
+    // more than a second away and should be rewritten
+    bool checkUlpTime(uint32_t ulpEpoch, uint32_t& corrected);
+
+    // Poll `server` (dotted IPv4) every `intervalS` from a background task
+    void startSntp(const char* server, uint32_t intervalS);
+
+    Stats getStats();
+
+private:
+    struct Sample {
+        int64_t offsetUs;
+        uint32_t delayUs;
+        TIME_SOURCE source;
+        bool used;
+    };
+
+    portMUX_TYPE lock;
+    int64_t offsetUs;           // Local time = esp_timer + offsetUs
+    int64_t slewRemainingUs;
+    int64_t lastSlewUs;         // esp_timer at the last slew update
+    int64_t firstSyncUs;        // esp_timer at the first step, 0 before
+    int64_t lastSyncUs;
+
+    Sample samples[TIME_SYNC_FILTER_SIZE];
+    size_t sampleCount;
+    size_t sampleNext;
+
+    Stats stats;
+
+    const char* sntpServer;
+    uint32_t sntpIntervalS;
+    TaskHandle_t sntpTask;
+
+    // Both called with `lock` held
+    int64_t advance(int64_t monotonicUs);
+    void correct(int64_t correctionUs, bool step);
+
+    void addSample(int64_t offsetUs, int64_t delayUs, TIME_SOURCE source);
+    void clearSamples();
+
+    bool pollSntp(int socket);
+    static void sntpTaskEntry(void* parameter);
+};
@@ -0,0 +1,94 @@
+#include "UlpProgram.hpp"
+#include <soc/rtc_cntl_reg.h>
+#include <string.h>
+
+size_t UlpProgram::build(const Variables& variables, uint16_t secondsPerTick, ulp_insn_t* program) {
+    // Every variable is addressed from one base word kept in R2, so no
+    // access needs its own I_MOVI. LD/ST offsets are unsigned, so the base
+    // is the lowest variable; wherever the linker put them, the offsets fit
+    // in 11 bits because RTC slow memory is 2048 words.
+    const uint16_t words[] = {
+        variables.epochLow, variables.epochHigh, variables.fracStep, variables.fracAcc,
+        variables.ticks, variables.tickDone, variables.tickRtcLow, variables.tickRtcHigh
+    };
+    uint16_t base = words[0];
+    for (uint16_t word : words) {
+        if (word < base) base = word;
+    }
+    const uint16_t epochLow = variables.epochLow - base;
+    const uint16_t epochHigh = variables.epochHigh - base;
+    const uint16_t fracStep = variables.fracStep - base;
+    const uint16_t fracAcc = variables.fracAcc - base;
+    const uint16_t ticks = variables.ticks - base;
+    const uint16_t tickDone = variables.tickDone - base;
+    const uint16_t tickRtcLow = variables.tickRtcLow - base;
+    const uint16_t tickRtcHigh = variables.tickRtcHigh - base;
+
+    // ULP program (runs every `secondsPerTick` seconds, awake or asleep):
+    // 1. Pick the next sleep period from the fractional accumulator
+    // 2. Open the tick: bump ulp_ticks
+    // 3. Add the elapsed seconds to the 32-bit epoch, held as two 16-bit halves
+    // 4. Record the RTC slow counter for calibration
+    // 5. Close the tick: ulp_tick_done = ulp_ticks
+    // Main power returning wakes the CPU through ext0, not through the ULP.
+    const ulp_insn_t instructions[] = {
+        I_MOVI(R2, base),
+
+        // A tick is N + fraction slow clock cycles. Period register 0
+        // holds N and register 1 N + 1; add the fraction to a 16-bit
+        // accumulator and sleep N + 1 whenever it carries.
+        I_LD(R0, R2, fracAcc),
+        I_LD(R1, R2, fracStep),
+        I_ADDR(R0, R0, R1),
+        M_BXF(1),             // Branch to label 1 on carry
+        I_SLEEP_CYCLE_SEL(0),
+        M_BX(2),
+        M_LABEL(1),
+        I_SLEEP_CYCLE_SEL(1),
+        M_LABEL(2),
+        I_ST(R0, R2, fracAcc),
+
+        // Bump the tick count, keeping it in R3 for ulp_tick_done
+        I_LD(R3, R2, ticks),
+        I_ADDI(R3, R3, 1),
+        I_ST(R3, R2, ticks),
+
+        // Epoch seconds: one add, and the high half only on carry (once
+        // every 18 hours, out of line at the end)
+        I_LD(R0, R2, epochLow),
+        I_ADDI(R0, R0, secondsPerTick),
+        I_ST(R0, R2, epochLow),
+        M_BXF(5),             // Branch to label 5 on carry
+        M_LABEL(6),
+
+        // Latch the RTC slow counter; the latch takes up to one slow clock
+        // cycle. Poll a bounded number of times so a stuck latch can cost
+        // a calibration but never stall the clock.
+        I_WR_REG_BIT(RTC_CNTL_TIME_UPDATE_REG, RTC_CNTL_TIME_UPDATE_S, 1),
+        I_MOVI(R1, 0),
+        M_LABEL(3),
+        I_RD_REG(RTC_CNTL_TIME_UPDATE_REG, RTC_CNTL_TIME_VALID_S, RTC_CNTL_TIME_VALID_S),
+        M_BGE(4, 1),          // Branch to label 4 once latched
+        I_ADDI(R1, R1, 1),
+        I_MOVR(R0, R1),
+        M_BL(3, 64),          // Poll again while R0 < 64
+        M_LABEL(4),
+        I_RD_REG(RTC_CNTL_TIME0_REG, 0, 15),
+        I_ST(R0, R2, tickRtcLow),
+        I_RD_REG(RTC_CNTL_TIME0_REG, 16, 31),
+        I_ST(R0, R2, tickRtcHigh),
+        I_ST(R3, R2, tickDone),
+        I_HALT(),
+
+        // Label 5: the low half wrapped, carry into the high half
+        M_LABEL(5),
+        I_LD(R0, R2, epochHigh),
+        I_ADDI(R0, R0, 1),
+        I_ST(R0, R2, epochHigh),
+        M_BX(6)
+    };
+
+    static_assert(sizeof(instructions) / sizeof(ulp_insn_t) <= MAX_INSTRUCTIONS, "ULP program too long");
+    memcpy(program, instructions, sizeof(instructions));
+    return sizeof(instructions) / sizeof(ulp_insn_t);
+}
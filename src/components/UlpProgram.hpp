@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp32/ulp.h>
+
+// The timekeeping ULP program, built apart from TimeKeeper so that the
+// exact instructions loaded on the device can also be run by the host
+// simulator (tools/ulp_sim).
+class UlpProgram {
+public:
+    // Upper bound on the program length, macros included
+    static constexpr size_t MAX_INSTRUCTIONS = 96;
+
+    // Word offsets from the start of RTC slow memory of the variables the
+    // program uses (see TimeKeeper.cpp for what each holds)
+    struct Variables {
+        uint16_t epochLow;
+        uint16_t epochHigh;
+        uint16_t fracStep;
+        uint16_t fracAcc;
+        uint16_t ticks;
+        uint16_t tickDone;
+        uint16_t tickRtcLow;
+        uint16_t tickRtcHigh;
+    };
+
+    // Write the program into `program` (MAX_INSTRUCTIONS entries), labels
+    // and branch macros unresolved as ulp_process_macros_and_load() wants
+    // them, and return its length. Each run adds `secondsPerTick` to the
+    // epoch; the caller programs the matching sleep period.
+    static size_t build(const Variables& variables, uint16_t secondsPerTick, ulp_insn_t* program);
+};
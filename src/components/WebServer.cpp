@@ -1,74 +1,193 @@
 #include "WebServer.hpp"
+#include "SystemLogger.hpp"
+#include "JsonReader.hpp"
+#include "RequestArgs.hpp"
+#include "Calendar.hpp"
+#include "TimeKeeper.hpp"
+#include "../generated/web_assets.h"
 #include <nvs.h>
 #include <nvs_flash.h>
+#include <mbedtls/base64.h>
+#include <esp_timer.h>
 
+static const char* JSON_OK = "{\"status\":\"ok\"}";
+
+// Accepts "RRGGBB" / "#RRGGBB" strings or a number
+static bool parseColor(const JsonField& field, uint32_t& color) {
+    if (field.type == JSON_NUMBER) {
+        if (field.number < 0 || field.number > 0xFFFFFF) return false;
+        color = field.number;
+        return true;
+    }
+    return field.type == JSON_STRING && RequestArgs::parseColor(field.string, color);
+}
+
+// Write `text` as a JSON string body (no quotes); false if it does not fit
+static bool writeJsonString(char*& out, char* end, const char* text) {
+    for (; *text; text++) {
+        unsigned char c = *text;
+        size_t room = end - out;
+        if (c == '"' || c == '\\') {
+            if (room < 2) return false;
+            *out++ = '\\';
+            *out++ = c;
+        } else if (c < 0x20) {
+            if (room < 6) return false;
+            out += snprintf(out, room, "\\u%04x", c);
+        } else {
+            if (room < 1) return false;
+            *out++ = c;
+        }
+    }
+    return true;
+}
 
 void WebServerManager::init() {
     server = nullptr;
     displayControlCallback = nullptr;
+    profiler = nullptr;
+    latencyTrace = nullptr;
+    stateSnapshot = nullptr;
+    timeSync = nullptr;
+    timeKeeper = nullptr;
+    stateSequence = 0;
+    stateReads = 0;
+    stateNotModified = 0;
+    handlerHeapDeltaMax = 0;
+    memset(&overflow, 0, sizeof(overflow));
+    submitWaited = 0;
+    submitMerged = 0;
+    submitRejected = 0;
+    stateWaiterCount = 0;
+    wsClientCount = 0;
+    wsMessages = 0;
+    wsSubmitted = 0;
+    lastPushedVersion = 0;
+    pollTimerRunning = false;
+    for (size_t i = 0; i < STATE_MAX_WAITERS; i++) {
+        stateWaiters[i].active = false;
+    }
+    for (size_t i = 0; i < WS_MAX_CLIENTS; i++) {
+        wsClients[i].active = false;
+    }
+
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = onPollTimer;
+    timerArgs.arg = this;
+    timerArgs.name = "state_poll";
+    esp_timer_create(&timerArgs, &pollTimer);
+    pagesServed = 0;
+    pagesNotModified = 0;
+    pageBytesSent = 0;
+    args[0] = '\0';
+
+    // Precompute the Basic credentials so each request is a string compare
+    char credentials[48];
+    snprintf(credentials, sizeof(credentials), "%s:%s", WEB_USERNAME, WEB_PASSWORD);
+    strcpy(authHeader, "Basic ");
+    size_t encoded = 0;
+    mbedtls_base64_encode((unsigned char*)authHeader + 6, sizeof(authHeader) - 6, &encoded,
+                          (const unsigned char*)credentials, strlen(credentials));
+    authHeader[6 + encoded] = '\0';
+    authHeaderLength = 6 + encoded;
+
+    sessions.init();
+    tokenAuth = {};
+    basicAuth = {};
+}
+
+template<WebServerManager::Handler handler>
+void WebServerManager::registerUri(const char* uri, httpd_method_t method) {
+    httpd_uri_t route = {};
+    route.uri = uri;
+    route.method = method;
+    route.handler = dispatch<handler>;
+    route.user_ctx = this;
+    httpd_register_uri_handler(server, &route);
 }
 
 void WebServerManager::begin() {
     initWiFiAP();
 
-    server = new WebServer(80);
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.stack_size = HTTP_SERVER_STACK_SIZE;
+    config.task_priority = HTTP_SERVER_PRIORITY;
+    config.core_id = HTTP_SERVER_CORE;
+    config.max_open_sockets = HTTP_MAX_OPEN_SOCKETS;
+    config.max_uri_handlers = 24;
+    config.lru_purge_enable = true;  // Evict idle keep-alive sockets under load
+
+    if (httpd_start(&server, &config) != ESP_OK) {
+        LOG_E(WEB, "WebServer: ERROR - httpd_start failed");
+        server = nullptr;
+        return;
+    }
 
     // Route handlers
-    server->on("/", [this]() { handleRoot(); });
-    server->on("/control", [this]() { handleUserControl(); });
-    server->on("/admin", [this]() { handleAdmin(); });
-
-    // API endpoints - using uri() and method() to match routes with query params
-    server->on("/api/header/text", [this]() {
-        if (server->method() == HTTP_POST) apiSetHeaderText();
-    });
-    server->on("/api/header/color", [this]() {
-        if (server->method() == HTTP_POST) apiSetHeaderColor();
-    });
-    server->on("/api/time/color", [this]() {
-        if (server->method() == HTTP_POST) apiSetTimeColor();
-    });
-    server->on("/api/bg/color", [this]() {
-        if (server->method() == HTTP_POST) apiSetBgColor();
-    });
-    server->on("/api/brightness", [this]() {
-        if (server->method() == HTTP_POST) apiSetBrightness();
-    });
-    server->on("/api/power", [this]() {
-        if (server->method() == HTTP_POST) apiSetDisplayPower();
-    });
-    server->on("/api/time/sync", [this]() {
-        if (server->method() == HTTP_POST) apiSyncTime();
-    });
-    server->on("/api/wifi", [this]() {
-        if (server->method() == HTTP_POST) apiUpdateWiFiCredentials();
-    });
+    registerUri<&WebServerManager::handleRoot>("/", HTTP_GET);
+    registerUri<&WebServerManager::handleUserControl>("/control", HTTP_GET);
+    registerUri<&WebServerManager::handleAdmin>("/admin", HTTP_GET);
+    registerUri<&WebServerManager::handleLogin>("/login", HTTP_GET);
+
+    // API endpoints
+    registerUri<&WebServerManager::apiSetHeaderText>("/api/header/text", HTTP_POST);
+    registerUri<&WebServerManager::apiSetHeaderColor>("/api/header/color", HTTP_POST);
+    registerUri<&WebServerManager::apiSetTimeColor>("/api/time/color", HTTP_POST);
+    registerUri<&WebServerManager::apiSetBgColor>("/api/bg/color", HTTP_POST);
+    registerUri<&WebServerManager::apiSetBrightness>("/api/brightness", HTTP_POST);
+    registerUri<&WebServerManager::apiSetDisplayPower>("/api/power", HTTP_POST);
+    registerUri<&WebServerManager::apiSyncTime>("/api/time/sync", HTTP_POST);
+    registerUri<&WebServerManager::apiGetTime>("/api/time", HTTP_GET);
+    registerUri<&WebServerManager::apiUpdateWiFiCredentials>("/api/wifi", HTTP_POST);
+    registerUri<&WebServerManager::apiGetPerf>("/api/perf", HTTP_GET);
+    registerUri<&WebServerManager::apiGetTrace>("/api/trace", HTTP_GET);
+    registerUri<&WebServerManager::apiSetState>("/api/state", HTTP_POST);
+    registerUri<&WebServerManager::apiGetState>("/api/state", HTTP_GET);
+    registerUri<&WebServerManager::apiLogin>("/api/login", HTTP_POST);
+    registerUri<&WebServerManager::apiLogout>("/api/logout", HTTP_POST);
+
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    httpd_uri_t ws = {};
+    ws.uri = "/ws";
+    ws.method = HTTP_GET;
+    ws.handler = dispatch<&WebServerManager::handleWebSocket>;
+    ws.user_ctx = this;
+    ws.is_websocket = true;
+    httpd_register_uri_handler(server, &ws);
+#endif
 
     // Handle browser icon requests with 204 No Content (prevents 404 spam)
-    server->on("/favicon.ico", HTTP_GET, [this]() {
-        server->send(204);  // 204 No Content
-    });
-    server->on("/apple-touch-icon.png", HTTP_GET, [this]() {
-        server->send(204);  // 204 No Content
-    });
-    server->on("/apple-touch-icon-precomposed.png", HTTP_GET, [this]() {
-        server->send(204);  // 204 No Content
-    });
+    registerUri<&WebServerManager::handleNoContent>("/favicon.ico", HTTP_GET);
+    registerUri<&WebServerManager::handleNoContent>("/apple-touch-icon.png", HTTP_GET);
+    registerUri<&WebServerManager::handleNoContent>("/apple-touch-icon-precomposed.png", HTTP_GET);
 
-    server->onNotFound([this]() { handleNotFound(); });
+    httpd_register_err_handler(server, HTTPD_404_NOT_FOUND, handleNotFound);
 
-    server->begin();
-    Serial.println("HTTP server started");
+    LOG_I(WEB, "HTTP server started");
 }
 
-void WebServerManager::handleClient() {
-    if (server) {
-        server->handleClient();
-    }
+void WebServerManager::setDisplayControlCallback(SUBMIT_STATUS (*callback)(const LED_PANEL_REQUEST&)) {
+    displayControlCallback = callback;
 }
 
-void WebServerManager::setDisplayControlCallback(void (*callback)(LED_PANEL_REQUEST)) {
-    displayControlCallback = callback;
+void WebServerManager::setProfiler(PerfProfiler* profiler) {
+    this->profiler = profiler;
+}
+
+void WebServerManager::setLatencyTrace(LatencyTrace* trace) {
+    latencyTrace = trace;
+}
+
+void WebServerManager::setStateSnapshot(const SeqLock<DisplayStateSnapshot>* snapshot) {
+    stateSnapshot = snapshot;
+}
+
+void WebServerManager::setTimeSync(TimeSync* timeSync) {
+    this->timeSync = timeSync;
+}
+
+void WebServerManager::setTimeKeeper(TimeKeeper* timeKeeper) {
+    this->timeKeeper = timeKeeper;
 }
 
 void WebServerManager::initWiFiAP() {
@@ -82,240 +201,1228 @@ void WebServerManager::initWiFiAP() {
     WiFi.mode(WIFI_AP);
     WiFi.softAP(creds.ssid, creds.password);
 
-    Serial.println("WiFi AP started");
-    Serial.printf("SSID: %s\n", creds.ssid);
-    Serial.printf("IP: %s\n", WiFi.softAPIP().toString().c_str());
+    LOG_I(WEB, "WiFi AP started");
+    LOG_I(WEB, "SSID: %s", creds.ssid);
+    LOG_I(WEB, "IP: %s", WiFi.softAPIP().toString().c_str());
 }
 
-void WebServerManager::handleRoot() {
-    if (!authenticate()) {
-        return;
+// Pages send browsers without a session to the login page instead of a 401
+esp_err_t WebServerManager::handleRoot(httpd_req_t* req) {
+    return redirect(req, isAuthorized(req) ? "/control" : "/login");
+}
+
+esp_err_t WebServerManager::handleUserControl(httpd_req_t* req) {
+    if (!isAuthorized(req)) {
+        return redirect(req, "/login");
     }
-    server->sendHeader("Location", "/control");
-    server->send(302);
+    return sendPage(req, CONTROL_HTML_GZ, CONTROL_HTML_GZ_LEN, CONTROL_HTML_ETAG);
 }
 
-void WebServerManager::handleUserControl() {
-    if (!authenticate()) {
-        return;
+esp_err_t WebServerManager::handleAdmin(httpd_req_t* req) {
+    if (!isAuthorized(req)) {
+        return redirect(req, "/login");
     }
-    server->send(200, "text/html", generateUserControlPage());
+    return sendPage(req, ADMIN_HTML_GZ, ADMIN_HTML_GZ_LEN, ADMIN_HTML_ETAG);
 }
 
-void WebServerManager::handleAdmin() {
-    if (!authenticate()) {
-        return;
+esp_err_t WebServerManager::handleLogin(httpd_req_t* req) {
+    return sendPage(req, LOGIN_HTML_GZ, LOGIN_HTML_GZ_LEN, LOGIN_HTML_ETAG);
+}
+
+esp_err_t WebServerManager::handleNoContent(httpd_req_t* req) {
+    httpd_resp_set_status(req, "204 No Content");
+    return httpd_resp_send(req, nullptr, 0);
+}
+
+esp_err_t WebServerManager::handleNotFound(httpd_req_t* req, httpd_err_code_t) {
+    LOG_W(WEB, "WebServer: 404 Not Found - URI: %s, Method: %s",
+                  req->uri, http_method_str((enum http_method)req->method));
+    httpd_resp_set_status(req, "404 Not Found");
+    httpd_resp_set_type(req, "text/plain");
+    return httpd_resp_sendstr(req, "404: Not Found");
+}
+
+esp_err_t WebServerManager::apiSetHeaderText(httpd_req_t* req) {
+    LOG_D(WEB, "WebServer: apiSetHeaderText called");
+
+    if (!authenticate(req)) {
+        LOG_W(WEB, "WebServer: Authentication failed");
+        return ESP_OK;
+    }
+    if (!readArgs(req)) {
+        return ESP_OK;
+    }
+
+    // The decoded value is NUL-terminated in args, so it goes to the
+    // display (which copies it into the message pool) without another copy
+    std::string_view text;
+    if (!requireArg(req, "text", text)) {
+        return ESP_OK;
+    }
+    LOG_D(WEB, "WebServer: Received text='%s'", text.data());
+
+    if (!RequestArgs::validateText(text, 0, MAX_HEADER_TEXT_LEN)) {
+        return sendError(req, "400 Bad Request", "invalid text");
     }
-    server->send(200, "text/html", generateAdminPage());
+
+    if (displayControlCallback) {
+        LED_PANEL_REQUEST request;
+        request.action = SET_HEADER_T;
+        request.data.text = text.data();
+        if (!submitRequest(req, request)) return ESP_OK;
+        LOG_D(WEB, "WebServer: Request sent to display");
+    } else {
+        LOG_E(WEB, "WebServer: ERROR - displayControlCallback is NULL");
+    }
+
+    return sendJson(req, HTTPD_200, JSON_OK);
 }
 
-void WebServerManager::handleNotFound() {
-    String uri = server->uri();
-    Serial.printf("WebServer: 404 Not Found - URI: %s, Method: %s\n",
-                  uri.c_str(),
-                  server->method() == HTTP_GET ? "GET" : "POST");
-    Serial.printf("WebServer: Args count: %d\n", server->args());
-    for (int i = 0; i < server->args(); i++) {
-        Serial.printf("  Arg %d: %s = %s\n", i, server->argName(i).c_str(), server->arg(i).c_str());
+esp_err_t WebServerManager::apiSetHeaderColor(httpd_req_t* req) {
+    LOG_D(WEB, "WebServer: apiSetHeaderColor called");
+
+    if (!authenticate(req)) {
+        LOG_W(WEB, "WebServer: Authentication failed");
+        return ESP_OK;
+    }
+    if (!readArgs(req)) {
+        return ESP_OK;
     }
-    server->send(404, "text/plain", "404: Not Found");
+
+    std::string_view value;
+    uint32_t color;
+    if (!requireArg(req, "color", value)) {
+        return ESP_OK;
+    }
+    if (!RequestArgs::parseColor(value, color)) {
+        return sendError(req, "400 Bad Request", "invalid color");
+    }
+    LOG_D(WEB, "WebServer: Parsed color=0x%06X", color);
+
+    if (displayControlCallback) {
+        LED_PANEL_REQUEST request;
+        request.action = SET_HEADER_COL;
+        request.data.color = color;
+        request.traceId = latencyTrace ? latencyTrace->begin() : 0;
+        if (!submitRequest(req, request)) return ESP_OK;
+        LOG_D(WEB, "WebServer: Request sent to display");
+    }
+
+    return sendJson(req, HTTPD_200, JSON_OK);
 }
 
-void WebServerManager::apiSetHeaderText() {
-    Serial.println("WebServer: apiSetHeaderText called");
+esp_err_t WebServerManager::apiSetTimeColor(httpd_req_t* req) {
+    if (!authenticate(req) || !readArgs(req)) {
+        return ESP_OK;
+    }
 
-    if (!authenticate()) {
-        Serial.println("WebServer: Authentication failed");
-        return;
+    std::string_view value;
+    uint32_t color;
+    if (!requireArg(req, "color", value)) {
+        return ESP_OK;
+    }
+    if (!RequestArgs::parseColor(value, color)) {
+        return sendError(req, "400 Bad Request", "invalid color");
     }
 
-    if (server->hasArg("text")) {
-        String text = server->arg("text");
-        Serial.printf("WebServer: Received text='%s'\n", text.c_str());
+    if (displayControlCallback) {
+        LED_PANEL_REQUEST request;
+        request.action = SET_TIME_COL;
+        request.data.color = color;
+        if (!submitRequest(req, request)) return ESP_OK;
+    }
 
-        if (displayControlCallback) {
-            LED_PANEL_REQUEST req;
-            req.action = SET_HEADER_T;
-            strncpy(req.data.text, text.c_str(), sizeof(req.data.text) - 1);
-            req.data.text[sizeof(req.data.text) - 1] = '\0';
-            displayControlCallback(req);
-            Serial.println("WebServer: Request sent to display");
-        } else {
-            Serial.println("WebServer: ERROR - displayControlCallback is NULL");
-        }
+    return sendJson(req, HTTPD_200, JSON_OK);
+}
 
-        server->send(200, "application/json", "{\"status\":\"ok\"}");
-    } else {
-        Serial.println("WebServer: ERROR - missing 'text' parameter");
-        server->send(400, "application/json", "{\"status\":\"error\",\"message\":\"missing text\"}");
+esp_err_t WebServerManager::apiSetBgColor(httpd_req_t* req) {
+    if (!authenticate(req) || !readArgs(req)) {
+        return ESP_OK;
+    }
+
+    std::string_view value;
+    uint32_t color;
+    if (!requireArg(req, "color", value)) {
+        return ESP_OK;
+    }
+    if (!RequestArgs::parseColor(value, color)) {
+        return sendError(req, "400 Bad Request", "invalid color");
     }
+
+    if (displayControlCallback) {
+        LED_PANEL_REQUEST request;
+        request.action = SET_BG_COL;
+        request.data.color = color;
+        if (!submitRequest(req, request)) return ESP_OK;
+    }
+
+    return sendJson(req, HTTPD_200, JSON_OK);
 }
 
-void WebServerManager::apiSetHeaderColor() {
-    Serial.println("WebServer: apiSetHeaderColor called");
+esp_err_t WebServerManager::apiSetBrightness(httpd_req_t* req) {
+    LOG_D(WEB, "WebServer: apiSetBrightness called");
 
-    if (!authenticate()) {
-        Serial.println("WebServer: Authentication failed");
-        return;
+    if (!authenticate(req)) {
+        LOG_W(WEB, "WebServer: Authentication failed");
+        return ESP_OK;
+    }
+    if (!readArgs(req)) {
+        return ESP_OK;
     }
 
-    if (server->hasArg("color")) {
-        String colorStr = server->arg("color");
-        Serial.printf("WebServer: Received color='%s'\n", colorStr.c_str());
+    std::string_view value;
+    uint8_t brightness;
+    if (!requireArg(req, "brightness", value)) {
+        return ESP_OK;
+    }
+    if (!RequestArgs::parseByte(value, brightness)) {
+        return sendError(req, "400 Bad Request", "invalid brightness");
+    }
+    LOG_D(WEB, "WebServer: Received brightness=%u", brightness);
+
+    if (displayControlCallback) {
+        LED_PANEL_REQUEST request;
+        request.action = SET_LED_BRIGHT;
+        request.data.brightness = brightness;
+        if (!submitRequest(req, request)) return ESP_OK;
+        LOG_D(WEB, "WebServer: Request sent to display");
+    }
 
-        if (displayControlCallback) {
-            LED_PANEL_REQUEST req;
-            req.action = SET_HEADER_COL;
-            req.data.color = strtoul(colorStr.c_str(), nullptr, 16);
-            Serial.printf("WebServer: Parsed color=0x%06X\n", req.data.color);
-            displayControlCallback(req);
-            Serial.println("WebServer: Request sent to display");
-        }
+    return sendJson(req, HTTPD_200, JSON_OK);
+}
 
-        server->send(200, "application/json", "{\"status\":\"ok\"}");
-    } else {
-        Serial.println("WebServer: ERROR - missing 'color' parameter");
-        server->send(400, "application/json", "{\"status\":\"error\",\"message\":\"missing color\"}");
+esp_err_t WebServerManager::apiSetDisplayPower(httpd_req_t* req) {
+    if (!authenticate(req) || !readArgs(req)) {
+        return ESP_OK;
     }
+
+    std::string_view value;
+    if (!requireArg(req, "power", value)) {
+        return ESP_OK;
+    }
+    if (value != "on" && value != "off") {
+        return sendError(req, "400 Bad Request", "invalid power");
+    }
+
+    if (displayControlCallback) {
+        LED_PANEL_REQUEST request;
+        request.action = SET_LED_BRIGHT;
+        request.data.brightness = value == "on" ? 255 : 0;
+        if (!submitRequest(req, request)) return ESP_OK;
+    }
+
+    return sendJson(req, HTTPD_200, JSON_OK);
 }
 
-void WebServerManager::apiSetTimeColor() {
-    if (!authenticate()) {
-        return;
+esp_err_t WebServerManager::apiSyncTime(httpd_req_t* req) {
+    // Receive timestamp for the exchange, before anything else adds to it
+    int64_t receivedMs = timeSync ? timeSync->nowUs() / 1000 : 0;
+
+    if (!authenticate(req) || !readArgs(req)) {
+        return ESP_OK;
+    }
+    if (!timeSync) {
+        return sendJson(req, "503 Service Unavailable", "{\"status\":\"error\",\"message\":\"time sync not running\"}");
     }
 
-    if (server->hasArg("color")) {
-        if (displayControlCallback) {
-            LED_PANEL_REQUEST req;
-            req.action = SET_TIME_COL;
-            req.data.color = strtoul(server->arg("color").c_str(), nullptr, 16);
-            displayControlCallback(req);
+    std::string_view value;
+    if (requestArgs.get("t0", value)) {
+        return syncExchange(req, value, receivedMs);
+    }
+
+    // Whole seconds set by hand
+    std::string_view hourArg, minuteArg, secondArg;
+    if (!requireArg(req, "hour", hourArg) || !requireArg(req, "minute", minuteArg) ||
+        !requireArg(req, "second", secondArg)) {
+        return ESP_OK;
+    }
+
+    uint32_t hour, minute, second;
+    if (!RequestArgs::parseUnsigned(hourArg, 23, hour) ||
+        !RequestArgs::parseUnsigned(minuteArg, 59, minute) ||
+        !RequestArgs::parseUnsigned(secondArg, 59, second)) {
+        return sendError(req, "400 Bad Request", "invalid time data");
+    }
+
+    timeSync->setTimeOfDay(hour, minute, second);
+    LOG_I(WEB, "WebServer: time set to %02u:%02u:%02u", hour, minute, second);
+    return sendJson(req, HTTPD_200, JSON_OK);
+}
+
+esp_err_t WebServerManager::syncExchange(httpd_req_t* req, std::string_view t0Arg, int64_t receivedMs) {
+    uint64_t t0;
+    if (!RequestArgs::parseUnsigned64(t0Arg, INT64_MAX / 1000, t0)) {
+        return sendError(req, "400 Bad Request", "invalid t0");
+    }
+
+    // p0..p3 are the previous round (page send, our receive, our send,
+    // page receive), which only the page could complete
+    static const char* const PREVIOUS[] = { "p0", "p1", "p2", "p3" };
+    std::string_view previousArg;
+    if (requestArgs.get(PREVIOUS[0], previousArg)) {
+        uint64_t previous[4];
+        for (size_t i = 0; i < 4; i++) {
+            if (!requestArgs.get(PREVIOUS[i], previousArg) ||
+                !RequestArgs::parseUnsigned64(previousArg, INT64_MAX / 1000, previous[i])) {
+                return sendError(req, "400 Bad Request", "invalid sample");
+            }
+        }
+        timeSync->addServerExchange(previous[0] * 1000, previous[1] * 1000, previous[2] * 1000,
+                                    previous[3] * 1000, TIME_SOURCE_BROWSER);
+    }
+
+    char json[96];
+    snprintf(json, sizeof(json), "{\"t0\":%llu,\"t1\":%lld,\"t2\":%lld}",
+             (unsigned long long)t0, (long long)receivedMs, (long long)(timeSync->nowUs() / 1000));
+    return sendJson(req, HTTPD_200, json);
+}
+
+esp_err_t WebServerManager::apiGetTime(httpd_req_t* req) {
+    if (!authenticate(req)) {
+        return ESP_OK;
+    }
+    if (!timeSync) {
+        return sendJson(req, "503 Service Unavailable", "{\"status\":\"error\",\"message\":\"time sync not running\"}");
+    }
+
+    static const char* const SOURCES[] = { "none", "manual", "browser", "sntp" };
+    TimeSync::Stats stats = timeSync->getStats();
+    uint32_t epoch = timeSync->getEpoch();
+    Calendar::DateTime now = Calendar::fromEpoch(epoch);
+
+    char* json = responseJson;
+    const size_t size = sizeof(responseJson);
+    int used = snprintf(json, size,
+             "{\"date\":\"%04u-%02u-%02u\",\"weekday\":%u,\"epoch\":%u,"
+             "\"time\":\"%02u:%02u:%02u\",\"synced\":%s,\"source\":\"%s\","
+             "\"offsetUs\":%lld,\"delayUs\":%u,\"slewRemainingUs\":%lld,"
+             "\"totalCorrectionUs\":%lld,\"driftPpb\":%d,\"steps\":%u,\"slews\":%u,"
+             "\"samplesAccepted\":%u,\"samplesRejected\":%u,\"lastSyncAgeS\":%u,"
+             "\"ulpCorrections\":%u",
+             now.year, now.month, now.day, now.weekday, epoch,
+             now.hour, now.minute, now.second, stats.synced ? "true" : "false", SOURCES[stats.source],
+             (long long)stats.lastOffsetUs, stats.lastDelayUs, (long long)stats.slewRemainingUs,
+             (long long)stats.totalCorrectionUs, stats.driftPpb, stats.steps, stats.slews,
+             stats.samplesAccepted, stats.samplesRejected, stats.lastSyncAgeS, stats.ulpCorrections);
+
+    // Average deep-sleep current at the configured and other ULP periods
+    if (timeKeeper) {
+        static const uint32_t TICK_SECONDS[] = { 1, 2, 4, 10, 30, 60 };
+        used += snprintf(json + used, size - used,
+                         ",\"ulp\":{\"tickSeconds\":%u,\"awakeUsPerTick\":%u,\"sleepCurrentNa\":{",
+                         ULP_TICK_SECONDS, timeKeeper->getAwakeUsPerTick());
+        for (size_t i = 0; i < sizeof(TICK_SECONDS) / sizeof(TICK_SECONDS[0]); i++) {
+            used += snprintf(json + used, size - used, "%s\"%u\":%u", i ? "," : "",
+                             TICK_SECONDS[i], timeKeeper->estimateSleepCurrentNa(TICK_SECONDS[i]));
         }
+        used += snprintf(json + used, size - used, "}}");
+    }
+    snprintf(json + used, size - used, "}");
+    return sendJson(req, HTTPD_200, json);
+}
+
+esp_err_t WebServerManager::apiUpdateWiFiCredentials(httpd_req_t* req) {
+    if (!authenticate(req) || !readArgs(req)) {
+        return ESP_OK;
+    }
 
-        server->send(200, "application/json", "{\"status\":\"ok\"}");
+    std::string_view ssid, password;
+    if (!requireArg(req, "ssid", ssid) || !requireArg(req, "password", password)) {
+        return ESP_OK;
+    }
+
+    // WPA2 passphrases are 8..63 characters
+    WiFiCredentials creds;
+    if (!RequestArgs::validateText(ssid, 1, sizeof(creds.ssid) - 1)) {
+        return sendError(req, "400 Bad Request", "invalid ssid");
+    }
+    if (!RequestArgs::validateText(password, 8, sizeof(creds.password) - 1)) {
+        return sendError(req, "400 Bad Request", "invalid password");
+    }
+    memcpy(creds.ssid, ssid.data(), ssid.size() + 1);
+    memcpy(creds.password, password.data(), password.size() + 1);
+
+    if (saveWiFiCredentials(creds)) {
+        return sendJson(req, HTTPD_200, "{\"status\":\"ok\",\"message\":\"WiFi credentials saved. Restart to apply.\"}");
+    }
+    return sendJson(req, "500 Internal Server Error", "{\"status\":\"error\",\"message\":\"Failed to save credentials\"}");
+}
+
+esp_err_t WebServerManager::apiGetPerf(httpd_req_t* req) {
+    if (!authenticate(req)) {
+        return ESP_OK;
+    }
+
+    if (!profiler) {
+        return sendJson(req, "503 Service Unavailable", "{\"status\":\"error\",\"message\":\"profiler not running\"}");
+    }
+
+    // Sized for the full history, so a partial document is never sent
+    size_t capacity = profiler->jsonCapacity();
+    char* json = (char*)malloc(capacity);
+    if (!json) {
+        return sendError(req, "503 Service Unavailable", "out of memory");
+    }
+    esp_err_t result;
+    if (profiler->writeJson(json, capacity)) {
+        result = sendJson(req, HTTPD_200, json);
     } else {
-        server->send(400, "application/json", "{\"status\":\"error\",\"message\":\"missing color\"}");
+        LOG_E(WEB, "/api/perf: output exceeded %u bytes", (uint32_t)capacity);
+        result = sendError(req, "500 Internal Server Error", "perf output truncated");
     }
+    free(json);
+    return result;
 }
 
-void WebServerManager::apiSetBgColor() {
-    if (!authenticate()) {
-        return;
+esp_err_t WebServerManager::apiGetTrace(httpd_req_t* req) {
+    if (!authenticate(req)) {
+        return ESP_OK;
+    }
+
+    if (!latencyTrace) {
+        return sendJson(req, "503 Service Unavailable", "{\"status\":\"error\",\"message\":\"tracing disabled\"}");
     }
 
-    if (server->hasArg("color")) {
-        if (displayControlCallback) {
-            LED_PANEL_REQUEST req;
-            req.action = SET_BG_COL;
-            req.data.color = strtoul(server->arg("color").c_str(), nullptr, 16);
-            displayControlCallback(req);
+    // Stream the trace in chunks instead of building it in one buffer
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"ledstack-trace.json\"");
+
+    uint32_t cursor = 0;
+    size_t length;
+    while ((length = latencyTrace->writeChromeJson(responseJson, sizeof(responseJson), cursor)) > 0) {
+        if (httpd_resp_send_chunk(req, responseJson, length) != ESP_OK) {
+            return ESP_FAIL;
         }
+    }
+    return httpd_resp_send_chunk(req, nullptr, 0);
+}
 
-        server->send(200, "application/json", "{\"status\":\"ok\"}");
-    } else {
-        server->send(400, "application/json", "{\"status\":\"error\",\"message\":\"missing color\"}");
+esp_err_t WebServerManager::apiSetState(httpd_req_t* req) {
+    if (!authenticate(req)) {
+        return ESP_OK;
     }
+
+    if (!stateSnapshot || !displayControlCallback) {
+        return sendJson(req, "503 Service Unavailable", "{\"status\":\"error\",\"message\":\"display not ready\"}");
+    }
+
+    // If-Match: "<version>" makes the update conditional; "*" or none is unconditional
+    LED_PANEL_REQUEST request;
+    request.action = SET_STATE;
+    DisplayStatePatch& patch = request.data.state;
+    memset(&patch, 0, sizeof(patch));
+
+    char ifMatch[16];
+    if (httpd_req_get_hdr_value_str(req, "If-Match", ifMatch, sizeof(ifMatch)) == ESP_OK &&
+        strcmp(ifMatch, "*") != 0) {
+        const char* digits = ifMatch[0] == '"' ? ifMatch + 1 : ifMatch;
+        char* end;
+        patch.ifMatch = strtoul(digits, &end, 10);
+        if (end == digits || patch.ifMatch == 0) {
+            return sendJson(req, "400 Bad Request", "{\"status\":\"error\",\"message\":\"invalid If-Match\"}");
+        }
+    }
+
+    args[0] = '\0';
+    if (!receiveBody(req, 0)) {
+        return ESP_OK;
+    }
+
+    JsonReader json;
+    JsonField field;
+    if (!json.begin(args)) {
+        return sendJson(req, "400 Bad Request", "{\"status\":\"error\",\"message\":\"expected a JSON object\"}");
+    }
+    while (json.next(field)) {
+        bool valid;
+        if (strcmp(field.key, "brightness") == 0) {
+            valid = field.type == JSON_NUMBER && field.number >= 0 && field.number <= 255;
+            patch.brightness = field.number;
+            patch.fields |= FIELD_BRIGHTNESS;
+        } else if (strcmp(field.key, "headerText") == 0) {
+            valid = field.type == JSON_STRING && strlen(field.string) <= MAX_HEADER_TEXT_LEN;
+            patch.headerText = field.string;
+            patch.fields |= FIELD_HEADER_TEXT;
+        } else if (strcmp(field.key, "headerColor") == 0) {
+            valid = parseColor(field, patch.headerColor);
+            patch.fields |= FIELD_HEADER_COLOR;
+        } else if (strcmp(field.key, "timeColor") == 0) {
+            valid = parseColor(field, patch.timeColor);
+            patch.fields |= FIELD_TIME_COLOR;
+        } else if (strcmp(field.key, "bgColor") == 0) {
+            valid = parseColor(field, patch.bgColor);
+            patch.fields |= FIELD_BG_COLOR;
+        } else {
+            valid = false;
+        }
+
+        if (!valid) {
+            LOG_W(WEB, "WebServer: invalid state field '%s'", field.key);
+            return sendJson(req, "400 Bad Request", "{\"status\":\"error\",\"message\":\"invalid field\"}");
+        }
+    }
+    if (json.hasError()) {
+        return sendJson(req, "400 Bad Request", "{\"status\":\"error\",\"message\":\"malformed JSON\"}");
+    }
+
+    // submitRequest() stamps patch.sequence
+    if (!submitRequest(req, request)) {
+        return ESP_OK;
+    }
+
+    // The reply carries the state this submission produced. Rather than
+    // hold the server task until the display applies it, park the request
+    // and let pollState() answer; 202 if it is not applied in time or no
+    // waiter slot is free.
+    stateSnapshot->read(snapshot);
+    switch (applyOutcome(snapshot, patch.sequence)) {
+        case APPLY_DONE:     return sendState(req, HTTPD_200);
+        case APPLY_REJECTED: return sendState(req, "412 Precondition Failed");
+        case APPLY_PENDING:  break;
+    }
+    if (addStateWaiter(req, snapshot.version, patch.sequence, (int64_t)STATE_APPLY_TIMEOUT_MS * 1000)) {
+        return ESP_OK;  // Response is sent later by pollState()
+    }
+    return sendJson(req, "202 Accepted", "{\"status\":\"pending\"}");
 }
 
-void WebServerManager::apiSetBrightness() {
-    Serial.println("WebServer: apiSetBrightness called");
+WebServerManager::ApplyOutcome WebServerManager::applyOutcome(const DisplayStateSnapshot& state,
+                                                              uint32_t sequence) {
+    // Wrap-safe: submissions up to appliedSequence have been processed
+    int32_t behind = (int32_t)(state.appliedSequence - sequence);
+    if (behind < 0) return APPLY_PENDING;
 
-    if (!authenticate()) {
-        Serial.println("WebServer: Authentication failed");
-        return;
+    // Outcomes older than the mask are no longer known; report them as applied
+    if (behind < 32 && (state.rejectedMask >> behind) & 1) return APPLY_REJECTED;
+    return APPLY_DONE;
+}
+
+esp_err_t WebServerManager::apiGetState(httpd_req_t* req) {
+    if (!authenticate(req)) {
+        return ESP_OK;
+    }
+
+    if (!stateSnapshot) {
+        return sendJson(req, "503 Service Unavailable", "{\"status\":\"error\",\"message\":\"display not ready\"}");
+    }
+
+    stateSnapshot->read(snapshot);
+    stateReads++;
+
+    // If-None-Match: "<version>" names the state the client already has
+    uint32_t knownVersion = 0;
+    char ifNoneMatch[16];
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", ifNoneMatch, sizeof(ifNoneMatch)) == ESP_OK) {
+        knownVersion = strtoul(ifNoneMatch[0] == '"' ? ifNoneMatch + 1 : ifNoneMatch, nullptr, 10);
+    }
+    if (knownVersion != snapshot.version) {
+        return sendState(req, HTTPD_200);
+    }
+
+    // readArgs() has already answered (414/413); close the connection, as
+    // an unread body would otherwise be parsed as the next request
+    if (!readArgs(req)) {
+        return ESP_FAIL;
+    }
+
+    // Unchanged: with ?wait=<seconds> park the request until the state
+    // changes or the wait expires, otherwise answer 304 right away
+    std::string_view value;
+    uint32_t waitSeconds = 0;
+    if (requestArgs.get("wait", value) &&
+        !RequestArgs::parseUnsigned(value, UINT32_MAX, waitSeconds)) {
+        return sendError(req, "400 Bad Request", "invalid wait");
+    }
+    if (waitSeconds > STATE_LONG_POLL_MAX_S) waitSeconds = STATE_LONG_POLL_MAX_S;
+    if (waitSeconds > 0 && addStateWaiter(req, snapshot.version, 0, (int64_t)waitSeconds * 1000000)) {
+        return ESP_OK;  // Response is sent later by pollState()
+    }
+
+    stateNotModified++;
+    return sendNotModified(req, snapshot.version);
+}
+
+size_t WebServerManager::formatState() {
+    char* out = responseJson;
+    char* end = responseJson + sizeof(responseJson);
+
+    out += snprintf(out, end - out,
+                    "{\"version\":%u,\"brightness\":%u,\"headerColor\":\"%06X\","
+                    "\"timeColor\":\"%06X\",\"bgColor\":\"%06X\",\"headerText\":\"",
+                    snapshot.version, snapshot.brightness, snapshot.headerColor,
+                    snapshot.timeColor, snapshot.bgColor);
+    if (!writeJsonString(out, end - 3, snapshot.headerText)) {
+        return 0;
+    }
+    strcpy(out, "\"}");
+    return out + 2 - responseJson;
+}
+
+esp_err_t WebServerManager::sendState(httpd_req_t* req, const char* status) {
+    size_t length = formatState();
+    if (length == 0) {
+        return sendJson(req, "500 Internal Server Error", "{\"status\":\"error\",\"message\":\"state too large\"}");
+    }
+
+    char etag[16];
+    snprintf(etag, sizeof(etag), "\"%u\"", snapshot.version);
+    httpd_resp_set_hdr(req, "ETag", etag);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    httpd_resp_set_status(req, status);
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, responseJson, length);
+}
+
+esp_err_t WebServerManager::sendNotModified(httpd_req_t* req, uint32_t version) {
+    char etag[16];
+    snprintf(etag, sizeof(etag), "\"%u\"", version);
+    httpd_resp_set_hdr(req, "ETag", etag);
+    httpd_resp_set_status(req, "304 Not Modified");
+    return httpd_resp_send(req, nullptr, 0);
+}
+
+bool WebServerManager::addStateWaiter(httpd_req_t* req, uint32_t version, uint32_t sequence, int64_t waitUs) {
+    for (size_t i = 0; i < STATE_MAX_WAITERS; i++) {
+        StateWaiter& waiter = stateWaiters[i];
+        if (waiter.active) continue;
+
+        waiter.owner = this;
+        waiter.fd = httpd_req_to_sockfd(req);
+        waiter.version = version;
+        waiter.sequence = sequence;
+        waiter.deadlineUs = esp_timer_get_time() + waitUs;
+        waiter.active = true;
+
+        // Tie the waiter to the session so a closed socket cancels it
+        // before its descriptor can be reused
+        req->sess_ctx = &waiter;
+        req->free_ctx = cancelStateWaiter;
+
+        stateWaiterCount++;
+        updatePollTimer();
+        return true;
     }
+    return false;
+}
+
+void WebServerManager::cancelStateWaiter(void* ctx) {
+    StateWaiter* waiter = static_cast<StateWaiter*>(ctx);
+    if (!waiter->active) return;
+
+    waiter->active = false;
+    waiter->owner->stateWaiterCount--;
+    waiter->owner->updatePollTimer();
+}
+
+void WebServerManager::updatePollTimer() {
+    bool needed = stateWaiterCount > 0 || wsClientCount > 0 || overflow.fields != 0;
+    if (needed && !pollTimerRunning) {
+        esp_timer_start_periodic(pollTimer, STATE_POLL_INTERVAL_MS * 1000);
+    } else if (!needed && pollTimerRunning) {
+        esp_timer_stop(pollTimer);
+    }
+    pollTimerRunning = needed;
+}
 
-    if (server->hasArg("brightness")) {
-        int brightness = server->arg("brightness").toInt();
-        Serial.printf("WebServer: Received brightness=%d\n", brightness);
+void WebServerManager::onPollTimer(void* arg) {
+    // esp_timer task: hop onto the server task, which owns the sockets
+    WebServerManager* self = static_cast<WebServerManager*>(arg);
+    httpd_queue_work(self->server, pollState, self);
+}
 
-        if (displayControlCallback) {
-            LED_PANEL_REQUEST req;
-            req.action = SET_LED_BRIGHT;
-            req.data.brightness = brightness;
-            displayControlCallback(req);
-            Serial.println("WebServer: Request sent to display");
+void WebServerManager::pollState(void* arg) {
+    WebServerManager* self = static_cast<WebServerManager*>(arg);
+    if (self->overflow.fields && self->flushOverflow()) {
+        self->updatePollTimer();
+    }
+    if (self->stateWaiterCount == 0 && self->wsClientCount == 0) return;
+
+    self->stateSnapshot->read(self->snapshot);
+    self->pollWebSockets();
+    int64_t now = esp_timer_get_time();
+
+    for (size_t i = 0; i < STATE_MAX_WAITERS; i++) {
+        StateWaiter& waiter = self->stateWaiters[i];
+        if (!waiter.active) continue;
+
+        int fd = waiter.fd;
+        if (waiter.sequence != 0) {
+            ApplyOutcome outcome = applyOutcome(self->snapshot, waiter.sequence);
+            if (outcome == APPLY_PENDING && now < waiter.deadlineUs) continue;
+
+            if (outcome == APPLY_DONE) {
+                self->sendRawState(fd, HTTPD_200);
+            } else if (outcome == APPLY_REJECTED) {
+                self->sendRawState(fd, "412 Precondition Failed");
+            } else {
+                self->sendRawPending(fd);
+            }
+        } else {
+            bool changed = waiter.version != self->snapshot.version;
+            if (!changed && now < waiter.deadlineUs) continue;
+
+            if (changed) {
+                self->sendRawState(fd, HTTPD_200);
+            } else {
+                self->stateNotModified++;
+                self->sendRawNotModified(fd);
+            }
         }
 
-        server->send(200, "application/json", "{\"status\":\"ok\"}");
+        // Retire the waiter and detach it from the session
+        cancelStateWaiter(&waiter);
+        httpd_sess_set_ctx(self->server, fd, nullptr, nullptr);
+    }
+}
+
+esp_err_t WebServerManager::apiLogin(httpd_req_t* req) {
+    if (!readArgs(req)) {
+        return ESP_OK;
+    }
+
+    std::string_view user, password;
+    if (!requireArg(req, "user", user) || !requireArg(req, "password", password)) {
+        return ESP_OK;
+    }
+
+    // Both compares always run so timing does not say which one failed
+    bool valid = SessionTokens::equals(user.data(), user.size(), WEB_USERNAME, strlen(WEB_USERNAME));
+    valid &= SessionTokens::equals(password.data(), password.size(), WEB_PASSWORD, strlen(WEB_PASSWORD));
+    if (!valid) {
+        LOG_W(WEB, "WebServer: login failed");
+        return sendError(req, "401 Unauthorized", "invalid credentials");
+    }
+
+    char token[SessionTokens::TOKEN_LENGTH + 1];
+    sessions.issue(token, nowSeconds());
+
+    // Both buffers must outlive the send below; httpd keeps the pointers
+    char cookie[128];
+    snprintf(cookie, sizeof(cookie), "session=%s; Path=/; Max-Age=%d; HttpOnly; SameSite=Strict",
+             token, SESSION_TOKEN_TTL_S);
+    char json[128];
+    snprintf(json, sizeof(json), "{\"status\":\"ok\",\"token\":\"%s\",\"expiresIn\":%d}",
+             token, SESSION_TOKEN_TTL_S);
+
+    httpd_resp_set_hdr(req, "Set-Cookie", cookie);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    LOG_I(WEB, "WebServer: session issued");
+    return sendJson(req, HTTPD_200, json);
+}
+
+esp_err_t WebServerManager::apiLogout(httpd_req_t* req) {
+    if (!authenticate(req) || !readArgs(req)) {
+        return ESP_OK;
+    }
+
+    // ?all=1 rotates the signing key, ending every session
+    std::string_view all;
+    if (requestArgs.get("all", all) && all == "1") {
+        sessions.revokeAll();
+        LOG_I(WEB, "WebServer: all sessions revoked");
     } else {
-        Serial.println("WebServer: ERROR - missing 'brightness' parameter");
-        server->send(400, "application/json", "{\"status\":\"error\",\"message\":\"missing brightness\"}");
+        char header[SESSION_HEADER_SIZE];
+        const char* token;
+        size_t length;
+        if (findSessionToken(req, header, sizeof(header), token, length)) {
+            sessions.revoke(token, length, nowSeconds());
+        }
     }
+
+    httpd_resp_set_hdr(req, "Set-Cookie", "session=; Path=/; Max-Age=0; HttpOnly; SameSite=Strict");
+    return sendJson(req, HTTPD_200, JSON_OK);
 }
 
-void WebServerManager::apiSetDisplayPower() {
-    if (!authenticate()) {
+void WebServerManager::sendRawState(int fd, const char* status) {
+    size_t length = formatState();
+    if (length == 0) {
+        static const char body[] = "{\"status\":\"error\",\"message\":\"state too large\"}";
+        char header[128];
+        int headerLength = snprintf(header, sizeof(header),
+                                    "HTTP/1.1 500 Internal Server Error\r\nContent-Type: application/json\r\n"
+                                    "Content-Length: %u\r\n\r\n",
+                                    (unsigned)(sizeof(body) - 1));
+        httpd_socket_send(server, fd, header, headerLength, 0);
+        httpd_socket_send(server, fd, body, sizeof(body) - 1, 0);
         return;
     }
 
-    if (server->hasArg("power")) {
-        bool power = server->arg("power") == "on";
+    char header[160];
+    int headerLength = snprintf(header, sizeof(header),
+                                "HTTP/1.1 %s\r\nContent-Type: application/json\r\n"
+                                "Content-Length: %u\r\nETag: \"%u\"\r\nCache-Control: no-cache\r\n\r\n",
+                                status, (unsigned)length, snapshot.version);
+    httpd_socket_send(server, fd, header, headerLength, 0);
+    httpd_socket_send(server, fd, responseJson, length, 0);
+}
+
+void WebServerManager::sendRawPending(int fd) {
+    static const char body[] = "{\"status\":\"pending\"}";
+    char header[128];
+    int headerLength = snprintf(header, sizeof(header),
+                                "HTTP/1.1 202 Accepted\r\nContent-Type: application/json\r\n"
+                                "Content-Length: %u\r\n\r\n",
+                                (unsigned)(sizeof(body) - 1));
+    httpd_socket_send(server, fd, header, headerLength, 0);
+    httpd_socket_send(server, fd, body, sizeof(body) - 1, 0);
+}
+
+void WebServerManager::sendRawNotModified(int fd) {
+    char header[96];
+    int headerLength = snprintf(header, sizeof(header),
+                                "HTTP/1.1 304 Not Modified\r\nETag: \"%u\"\r\nContent-Length: 0\r\n\r\n",
+                                snapshot.version);
+    httpd_socket_send(server, fd, header, headerLength, 0);
+}
 
-        if (displayControlCallback) {
-            LED_PANEL_REQUEST req;
-            req.action = SET_LED_BRIGHT;
-            req.data.brightness = power ? 255 : 0;
-            displayControlCallback(req);
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+esp_err_t WebServerManager::handleWebSocket(httpd_req_t* req) {
+    // The handshake arrives as a GET; esp_http_server has already sent the
+    // 101 by then, so a failed login just drops the connection
+    if (req->method == HTTP_GET) {
+        if (!stateSnapshot || !displayControlCallback || !isAuthorized(req)) {
+            LOG_W(WEB, "WebServer: WebSocket authentication failed");
+            return ESP_FAIL;
         }
+        return addWsClient(req) ? ESP_OK : ESP_FAIL;
+    }
 
-        server->send(200, "application/json", "{\"status\":\"ok\"}");
-    } else {
-        server->send(400, "application/json", "{\"status\":\"error\",\"message\":\"missing power\"}");
+    WsClient* client = static_cast<WsClient*>(req->sess_ctx);
+    if (!client || !client->active) {
+        return ESP_FAIL;
     }
+
+    uint8_t payload[WS_MESSAGE_SIZE * WS_MAX_MESSAGES_PER_FRAME];
+    httpd_ws_frame_t frame = {};
+    if (httpd_ws_recv_frame(req, &frame, 0) != ESP_OK || frame.len > sizeof(payload)) {
+        return ESP_FAIL;
+    }
+    frame.payload = payload;
+    if (frame.len > 0 && httpd_ws_recv_frame(req, &frame, frame.len) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    if (frame.type != HTTPD_WS_TYPE_BINARY || frame.len % WS_MESSAGE_SIZE != 0) {
+        return ESP_OK;  // Not a control message; ignore
+    }
+
+    // Each message is [action][field][value, 4 bytes little-endian].
+    // Values overwrite the connection's pending patch, so a burst of slider
+    // positions collapses into whatever is newest when the display is free.
+    bool sendState = false;
+    for (size_t offset = 0; offset < frame.len; offset += WS_MESSAGE_SIZE) {
+        const uint8_t* message = payload + offset;
+        uint8_t action = message[0];
+        uint8_t field = message[1];
+        uint32_t value = message[2] | (message[3] << 8) | (message[4] << 16) | ((uint32_t)message[5] << 24);
+        wsMessages++;
+
+        if (action == WS_GET) {
+            sendState = true;
+            continue;
+        }
+        if (action != WS_SET) continue;
+
+        DisplayStatePatch& pending = client->pending;
+        bool startsBatch = !pending.fields;
+        switch (field) {
+            case FIELD_BRIGHTNESS:   pending.brightness = value > 255 ? 255 : value; break;
+            case FIELD_HEADER_COLOR: pending.headerColor = value & 0xFFFFFF; break;
+            case FIELD_TIME_COLOR:   pending.timeColor = value & 0xFFFFFF; break;
+            case FIELD_BG_COLOR:     pending.bgColor = value & 0xFFFFFF; break;
+            default: continue;
+        }
+        pending.fields |= field;
+
+        // Traced from the first valid change of the batch, so an unknown
+        // field never opens a span
+        if (startsBatch && latencyTrace) {
+            client->traceId = latencyTrace->begin();
+        }
+    }
+
+    stateSnapshot->read(snapshot);
+    flushWsClient(*client);
+
+    size_t length;
+    if (sendState && (length = formatState()) > 0) {
+        httpd_ws_frame_t reply = {};
+        reply.type = HTTPD_WS_TYPE_TEXT;
+        reply.payload = (uint8_t*)responseJson;
+        reply.len = length;
+        httpd_ws_send_frame(req, &reply);
+    }
+    return ESP_OK;
+}
+
+bool WebServerManager::addWsClient(httpd_req_t* req) {
+    for (size_t i = 0; i < WS_MAX_CLIENTS; i++) {
+        WsClient& client = wsClients[i];
+        if (client.active) continue;
+
+        client.owner = this;
+        client.fd = httpd_req_to_sockfd(req);
+        client.inFlightSequence = 0;
+        client.traceId = 0;
+        memset(&client.pending, 0, sizeof(client.pending));
+        client.active = true;
+
+        // The session context follows the socket, so frames find their
+        // client and a close releases the slot
+        req->sess_ctx = &client;
+        req->free_ctx = closeWsClient;
+
+        wsClientCount++;
+        updatePollTimer();
+        LOG_I(WEB, "WebServer: WebSocket client %d connected", client.fd);
+        return true;
+    }
+
+    LOG_W(WEB, "WebServer: WebSocket rejected, %u clients connected", (unsigned)wsClientCount);
+    return false;
 }
 
-void WebServerManager::apiSyncTime() {
-    if (!authenticate()) {
+void WebServerManager::closeWsClient(void* ctx) {
+    WsClient* client = static_cast<WsClient*>(ctx);
+    if (!client->active) return;
+
+    // A patch that never got submitted ends its trace here
+    if (client->pending.fields && client->traceId && client->owner->latencyTrace) {
+        client->owner->latencyTrace->record(client->traceId, TRACE_DROPPED);
+    }
+
+    client->active = false;
+    client->owner->wsClientCount--;
+    client->owner->updatePollTimer();
+}
+
+void WebServerManager::flushWsClient(WsClient& client) {
+    if (!client.pending.fields) return;
+
+    // One submission in flight per connection: while the display is still
+    // applying the previous one, keep merging into the pending patch
+    if (client.inFlightSequence != 0 &&
+        (int32_t)(snapshot.appliedSequence - client.inFlightSequence) < 0) {
         return;
     }
 
-    if (server->hasArg("hour") && server->hasArg("minute") && server->hasArg("second")) {
-        if (displayControlCallback) {
-            LED_PANEL_REQUEST req;
-            req.action = SET_TIME_DATA;
-            req.data.timeData.hour = server->arg("hour").toInt();
-            req.data.timeData.minute = server->arg("minute").toInt();
-            req.data.timeData.second = server->arg("second").toInt();
-            displayControlCallback(req);
+    LED_PANEL_REQUEST request;
+    request.action = SET_STATE;
+    request.data.state = client.pending;
+    request.traceId = client.traceId;
+    if (submit(request, 0) != SUBMIT_OK) {
+        return;  // Retried on the next poll
+    }
+
+    client.inFlightSequence = request.data.state.sequence;
+    client.pending.fields = 0;
+    client.traceId = 0;
+    wsSubmitted++;
+}
+
+void WebServerManager::pollWebSockets() {
+    if (wsClientCount == 0) return;
+
+    for (size_t i = 0; i < WS_MAX_CLIENTS; i++) {
+        if (wsClients[i].active) flushWsClient(wsClients[i]);
+    }
+
+    // Push every applied change to all clients, including the sender, so
+    // sliders settle on what the panel actually shows
+    if (snapshot.version == lastPushedVersion) return;
+    lastPushedVersion = snapshot.version;
+
+    size_t length = formatState();
+    if (length == 0) return;
+    for (size_t i = 0; i < WS_MAX_CLIENTS; i++) {
+        if (!wsClients[i].active) continue;
+
+        httpd_ws_frame_t frame = {};
+        frame.type = HTTPD_WS_TYPE_TEXT;
+        frame.payload = (uint8_t*)responseJson;
+        frame.len = length;
+        httpd_ws_send_frame_async(server, wsClients[i].fd, &frame);
+    }
+}
+#else
+esp_err_t WebServerManager::handleWebSocket(httpd_req_t*) {
+    return ESP_FAIL;
+}
+
+void WebServerManager::pollWebSockets() {
+}
+#endif
+
+SUBMIT_STATUS WebServerManager::submit(LED_PANEL_REQUEST& request, uint32_t waitMs) {
+    uint32_t start = millis();
+    bool waited = false;
+
+    for (;;) {
+        // Changes merged earlier go first, so the display sees them in order
+        if (flushOverflow()) {
+            if (request.action == SET_STATE) {
+                request.data.state.sequence = stateSequence + 1;
+            }
+            if (displayControlCallback(request) == SUBMIT_OK) {
+                if (request.action == SET_STATE) stateSequence++;
+                if (waited) submitWaited++;
+                return SUBMIT_OK;
+            }
         }
 
-        server->send(200, "application/json", "{\"status\":\"ok\"}");
-    } else {
-        server->send(400, "application/json", "{\"status\":\"error\",\"message\":\"missing time data\"}");
+        // The callback has already rung the display job's doorbell
+        if (millis() - start >= waitMs) {
+            return SUBMIT_BUSY;
+        }
+        waited = true;
+        vTaskDelay(1);
     }
 }
 
-void WebServerManager::apiUpdateWiFiCredentials() {
-    if (!authenticate()) {
-        return;
+bool WebServerManager::flushOverflow() {
+    if (!overflow.fields) {
+        return true;
+    }
+
+    LED_PANEL_REQUEST request;
+    request.action = SET_STATE;
+    request.data.state = overflow;
+    request.data.state.sequence = stateSequence + 1;
+    if (displayControlCallback(request) != SUBMIT_OK) {
+        return false;
     }
 
-    if (server->hasArg("ssid") && server->hasArg("password")) {
-        WiFiCredentials creds;
-        strncpy(creds.ssid, server->arg("ssid").c_str(), sizeof(creds.ssid) - 1);
-        strncpy(creds.password, server->arg("password").c_str(), sizeof(creds.password) - 1);
-        creds.ssid[sizeof(creds.ssid) - 1] = '\0';
-        creds.password[sizeof(creds.password) - 1] = '\0';
+    stateSequence++;
+    overflow.fields = 0;
+    return true;
+}
 
-        if (saveWiFiCredentials(creds)) {
-            server->send(200, "application/json", "{\"status\":\"ok\",\"message\":\"WiFi credentials saved. Restart to apply.\"}");
-        } else {
-            server->send(500, "application/json", "{\"status\":\"error\",\"message\":\"Failed to save credentials\"}");
+bool WebServerManager::mergeOverflow(const LED_PANEL_REQUEST& request) {
+    switch (request.action) {
+        case SET_HEADER_COL:
+            overflow.headerColor = request.data.color;
+            overflow.fields |= FIELD_HEADER_COLOR;
+            return true;
+        case SET_TIME_COL:
+            overflow.timeColor = request.data.color;
+            overflow.fields |= FIELD_TIME_COLOR;
+            return true;
+        case SET_BG_COL:
+            overflow.bgColor = request.data.color;
+            overflow.fields |= FIELD_BG_COLOR;
+            return true;
+        case SET_LED_BRIGHT:
+            overflow.brightness = request.data.brightness;
+            overflow.fields |= FIELD_BRIGHTNESS;
+            return true;
+        default:
+            // Text needs pool space and time/batches must not be reordered
+            return false;
+    }
+}
+
+bool WebServerManager::submitRequest(httpd_req_t* req, LED_PANEL_REQUEST& request) {
+    if (submit(request, DISPLAY_SUBMIT_WAIT_MS) == SUBMIT_OK) {
+        return true;
+    }
+
+    // The overflow patch carries no trace; the span ends here either way
+    if (latencyTrace) {
+        latencyTrace->record(request.traceId, TRACE_DROPPED);
+    }
+
+    // Last-writer-wins fields wait in the overflow patch instead; the poll
+    // timer submits it once the display has caught up
+    if (mergeOverflow(request)) {
+        submitMerged++;
+        updatePollTimer();
+        sendJson(req, "202 Accepted", "{\"status\":\"merged\"}");
+        return false;
+    }
+
+    submitRejected++;
+    LOG_W(WEB, "WebServer: display busy, request rejected");
+    httpd_resp_set_hdr(req, "Retry-After", DISPLAY_RETRY_AFTER_S);
+    sendJson(req, "503 Service Unavailable", "{\"status\":\"error\",\"message\":\"display busy\"}");
+    return false;
+}
+
+bool WebServerManager::readArgs(httpd_req_t* req) {
+    args[0] = '\0';
+    size_t used = 0;
+
+    if (httpd_req_get_url_query_len(req) > 0) {
+        if (httpd_req_get_url_query_str(req, args, sizeof(args)) != ESP_OK) {
+            sendJson(req, "414 URI Too Long", "{\"status\":\"error\",\"message\":\"query too long\"}");
+            return false;
         }
-    } else {
-        server->send(400, "application/json", "{\"status\":\"error\",\"message\":\"missing ssid or password\"}");
+        used = strlen(args);
+    }
+
+    // Urlencoded form bodies are appended as if they were more query args
+    if (req->content_len > 0 && used > 0) {
+        args[used++] = '&';
+    }
+    if (!receiveBody(req, used)) {
+        return false;
     }
+    requestArgs.parse(args);
+    return true;
 }
 
-bool WebServerManager::authenticate() {
-    if (!server->authenticate(WEB_USERNAME, WEB_PASSWORD)) {
-        server->requestAuthentication();
+bool WebServerManager::receiveBody(httpd_req_t* req, size_t used) {
+    size_t remaining = req->content_len;
+    if (remaining == 0) {
+        return true;
+    }
+    if (used + remaining >= sizeof(args)) {
+        sendJson(req, "413 Payload Too Large", "{\"status\":\"error\",\"message\":\"body too large\"}");
         return false;
     }
+    while (remaining > 0) {
+        int received = httpd_req_recv(req, args + used, remaining);
+        if (received == HTTPD_SOCK_ERR_TIMEOUT) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        used += received;
+        remaining -= received;
+    }
+    args[used] = '\0';
     return true;
 }
 
+bool WebServerManager::requireArg(httpd_req_t* req, const char* key, std::string_view& value) {
+    if (requestArgs.get(key, value)) {
+        return true;
+    }
+
+    char message[32];
+    snprintf(message, sizeof(message), "missing %s", key);
+    LOG_W(WEB, "WebServer: %s", message);
+    sendError(req, "400 Bad Request", message);
+    return false;
+}
+
+esp_err_t WebServerManager::sendJson(httpd_req_t* req, const char* status, const char* json) {
+    httpd_resp_set_status(req, status);
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_sendstr(req, json);
+}
+
+void WebServerManager::recordHeapDelta(size_t freeBefore) {
+    size_t freeAfter = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    if (freeAfter < freeBefore && freeBefore - freeAfter > handlerHeapDeltaMax) {
+        handlerHeapDeltaMax = freeBefore - freeAfter;
+    }
+}
+
+esp_err_t WebServerManager::sendError(httpd_req_t* req, const char* status, const char* message) {
+    // Messages are fixed literals or argument names, never client text
+    char json[64];
+    snprintf(json, sizeof(json), "{\"status\":\"error\",\"message\":\"%s\"}", message);
+    return sendJson(req, status, json);
+}
+
+esp_err_t WebServerManager::sendPage(httpd_req_t* req, const uint8_t* gz, size_t length, const char* etag) {
+    // Strong ETag plus no-cache: the browser revalidates on every load and
+    // normally gets an empty 304 back
+    httpd_resp_set_hdr(req, "ETag", etag);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+
+    char ifNoneMatch[40];
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", ifNoneMatch, sizeof(ifNoneMatch)) == ESP_OK &&
+        strcmp(ifNoneMatch, etag) == 0) {
+        pagesNotModified++;
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, nullptr, 0);
+    }
+
+    pagesServed++;
+    pageBytesSent += length;
+    httpd_resp_set_type(req, "text/html");
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    return httpd_resp_send(req, (const char*)gz, length);
+}
+
+bool WebServerManager::isAuthorized(httpd_req_t* req) {
+    uint32_t start = ESP.getCycleCount();
+
+    char header[SESSION_HEADER_SIZE];
+    const char* token;
+    size_t length;
+    bool authorized;
+    AuthStats* stats;
+    if (findSessionToken(req, header, sizeof(header), token, length)) {
+        authorized = sessions.verify(token, length, nowSeconds());
+        stats = &tokenAuth;
+    } else if (header[0] != '\0') {
+        authorized = SessionTokens::equals(header, strlen(header), authHeader, authHeaderLength);
+        stats = &basicAuth;
+    } else {
+        return false;
+    }
+
+    uint32_t cycles = ESP.getCycleCount() - start;
+    stats->checks++;
+    stats->totalCycles += cycles;
+    if (cycles > stats->maxCycles) stats->maxCycles = cycles;
+    return authorized;
+}
+
+bool WebServerManager::authenticate(httpd_req_t* req) {
+    if (isAuthorized(req)) {
+        return true;
+    }
+
+    // No WWW-Authenticate: browsers should go through /login, not cache
+    // Basic credentials and resend them with every request
+    sendError(req, "401 Unauthorized", "unauthorized");
+    return false;
+}
+
+bool WebServerManager::findSessionToken(httpd_req_t* req, char* buffer, size_t size,
+                                        const char*& token, size_t& length) {
+    if (httpd_req_get_hdr_value_str(req, "Authorization", buffer, size) == ESP_OK) {
+        if (strncmp(buffer, "Bearer ", 7) != 0) {
+            return false;  // Some other scheme; left in buffer for the caller
+        }
+        token = buffer + 7;
+        length = strlen(token);
+        return true;
+    }
+
+    buffer[0] = '\0';
+    if (httpd_req_get_hdr_value_str(req, "Cookie", buffer, size) != ESP_OK) {
+        buffer[0] = '\0';
+        return false;
+    }
+    for (char* cookie = buffer; cookie; ) {
+        while (*cookie == ' ') cookie++;
+        char* end = strchr(cookie, ';');
+        if (strncmp(cookie, "session=", 8) == 0) {
+            token = cookie + 8;
+            length = end ? (size_t)(end - token) : strlen(token);
+            buffer[0] = '\0';  // Not an Authorization header
+            return true;
+        }
+        cookie = end ? end + 1 : nullptr;
+    }
+    buffer[0] = '\0';
+    return false;
+}
+
+uint32_t WebServerManager::nowSeconds() {
+    return esp_timer_get_time() / 1000000;
+}
+
+esp_err_t WebServerManager::redirect(httpd_req_t* req, const char* location) {
+    httpd_resp_set_status(req, "302 Found");
+    httpd_resp_set_hdr(req, "Location", location);
+    return httpd_resp_send(req, nullptr, 0);
+}
+
 bool WebServerManager::loadWiFiCredentials(WiFiCredentials& creds) {
     nvs_handle_t handle;
     esp_err_t err = nvs_open("wifi", NVS_READONLY, &handle);
@@ -366,252 +1473,3 @@ bool WebServerManager::saveWiFiCredentials(const WiFiCredentials& creds) {
 
     return err == ESP_OK;
 }
-
-String WebServerManager::generateUserControlPage() {
-    return R"(
-<!DOCTYPE html>
-<html>
-<head>
-    <meta charset="UTF-8">
-    <meta name="viewport" content="width=device-width, initial-scale=1.0">
-    <title>ledStack Control</title>
-    <style>
-        body { font-family: Arial, sans-serif; max-width: 600px; margin: 50px auto; padding: 20px; background: #1a1a1a; color: #fff; }
-        h1 { color: #4CAF50; }
-        .control-group { margin: 20px 0; padding: 15px; background: #2a2a2a; border-radius: 5px; }
-        label { display: block; margin-bottom: 5px; font-weight: bold; }
-        input[type="text"], input[type="number"], input[type="color"] { width: 100%; padding: 8px; margin-bottom: 10px; border: 1px solid #444; background: #333; color: #fff; border-radius: 3px; }
-        button { background: #4CAF50; color: white; padding: 10px 20px; border: none; border-radius: 5px; cursor: pointer; margin: 5px; }
-        button:hover { background: #45a049; }
-        .nav { margin-bottom: 20px; }
-        .nav a { color: #4CAF50; text-decoration: none; margin-right: 15px; }
-        .status { padding: 10px; margin-top: 10px; border-radius: 3px; display: none; }
-        .status.success { background: #4CAF50; }
-        .status.error { background: #f44336; }
-    </style>
-</head>
-<body>
-    <div class="nav">
-        <a href="/control">Control</a>
-        <a href="/admin">Admin</a>
-    </div>
-    <h1>ledStack Display Control</h1>
-
-    <div class='control-group'>
-        <h3>Display Power</h3>
-        <button onclick='setPower("on")'>Turn ON</button>
-        <button onclick='setPower("off")'>Turn OFF</button>
-    </div>
-
-    <div class='control-group'>
-        <h3>Header Text</h3>
-        <input type='text' id='headerText' placeholder='Enter header text'>
-        <button onclick='setHeaderText()'>Update Header</button>
-    </div>
-
-    <div class='control-group'>
-        <h3>Colors</h3>
-        <label>Header Color:</label>
-        <input type='color' id='headerColor' value='#0000ff'>
-        <button onclick='setHeaderColor()'>Update</button>
-
-        <label>Time Color:</label>
-        <input type='color' id='timeColor' value='#ffffff'>
-        <button onclick='setTimeColor()'>Update</button>
-
-        <label>Background Color:</label>
-        <input type='color' id='bgColor' value='#000000'>
-        <button onclick='setBgColor()'>Update</button>
-    </div>
-
-    <div class='control-group'>
-        <h3>Brightness</h3>
-        <input type='number' id='brightness' min='0' max='255' value='255'>
-        <button onclick='setBrightness()'>Update</button>
-    </div>
-
-    <div id="status" class="status"></div>
-
-    <script>
-        // Sync time on page load
-        function getTime(){
-            const now = new Date();
-            const hour = now.getHours();
-            const minute = now.getMinutes();
-            const second = now.getSeconds();
-
-            fetch('/api/time/sync?hour=' + hour + '&minute=' + minute + '&second=' + second, { method: 'POST' })
-                .then(r => r.json())
-                .then(d => console.log('Time synced with device'))
-                .catch(e => console.error('Time sync failed:', e));
-        }
-
-        window.addEventListener('load', function() {
-            getTime();
-        });
-
-        function showStatus(message, isError) {
-            const status = document.getElementById('status');
-            status.textContent = message;
-            status.className = 'status ' + (isError ? 'error' : 'success');
-            status.style.display = 'block';
-            setTimeout(() => status.style.display = 'none', 3000);
-        }
-
-        function setPower(state) {
-            fetch('/api/power?power=' + state, { method: 'POST' })
-                .then(r => r.json())
-                .then(d => showStatus('Display ' + state, false))
-                .catch(e => showStatus('Error: ' + e, true));
-                getTime();
-        }
-
-        function setHeaderText() {
-            const text = document.getElementById('headerText').value;
-            fetch('/api/header/text?text=' + encodeURIComponent(text), { method: 'POST' })
-                .then(r => r.json())
-                .then(d => showStatus('Header updated', false))
-                .catch(e => showStatus('Error: ' + e, true));
-                getTime();
-        }
-
-        function setHeaderColor() {
-            const color = document.getElementById('headerColor').value.substring(1);
-            fetch('/api/header/color?color=' + color, { method: 'POST' })
-                .then(r => r.json())
-                .then(d => showStatus('Header color updated', false))
-                .catch(e => showStatus('Error: ' + e, true));
-                getTime();
-        }
-
-        function setTimeColor() {
-            const color = document.getElementById('timeColor').value.substring(1);
-            fetch('/api/time/color?color=' + color, { method: 'POST' })
-                .then(r => r.json())
-                .then(d => showStatus('Time color updated', false))
-                .catch(e => showStatus('Error: ' + e, true));
-                getTime();
-        }
-
-        function setBgColor() {
-            const color = document.getElementById('bgColor').value.substring(1);
-            fetch('/api/bg/color?color=' + color, { method: 'POST' })
-                .then(r => r.json())
-                .then(d => showStatus('Background color updated', false))
-                .catch(e => showStatus('Error: ' + e, true));
-                getTime();
-        }
-
-        function setBrightness() {
-            const brightness = document.getElementById('brightness').value;
-            fetch('/api/brightness?brightness=' + brightness, { method: 'POST' })
-                .then(r => r.json())
-                .then(d => showStatus('Brightness updated', false))
-                .catch(e => showStatus('Error: ' + e, true));
-                getTime();
-        }
-    </script>
-</body>
-</html>
-)";
-}
-
-String WebServerManager::generateAdminPage() {
-    return R"(
-<!DOCTYPE html>
-<html>
-<head>
-    <meta charset="UTF-8">
-    <meta name="viewport" content="width=device-width, initial-scale=1.0">
-    <title>ledStack Admin</title>
-    <style>
-        body { font-family: Arial, sans-serif; max-width: 600px; margin: 50px auto; padding: 20px; background: #1a1a1a; color: #fff; }
-        h1 { color: #ff9800; }
-        .control-group { margin: 20px 0; padding: 15px; background: #2a2a2a; border-radius: 5px; }
-        label { display: block; margin-bottom: 5px; font-weight: bold; }
-        input[type="text"], input[type="password"] { width: 100%; padding: 8px; margin-bottom: 10px; border: 1px solid #444; background: #333; color: #fff; border-radius: 3px; }
-        button { background: #ff9800; color: white; padding: 10px 20px; border: none; border-radius: 5px; cursor: pointer; }
-        button:hover { background: #e68900; }
-        .nav { margin-bottom: 20px; }
-        .nav a { color: #ff9800; text-decoration: none; margin-right: 15px; }
-        .warning { background: #f44336; padding: 10px; border-radius: 3px; margin-bottom: 15px; }
-        .status { padding: 10px; margin-top: 10px; border-radius: 3px; display: none; }
-        .status.success { background: #4CAF50; }
-        .status.error { background: #f44336; }
-    </style>
-</head>
-<body>
-    <div class="nav">
-        <a href="/control">Control</a>
-        <a href="/admin">Admin</a>
-    </div>
-    <h1>ledStack Admin Panel</h1>
-
-    <div class="control-group">
-        <div class="warning">
-            <strong>Warning:</strong> Changes will take effect after ESP32 restart.
-        </div>
-        <h3>WiFi Access Point Settings</h3>
-        <label>SSID:</label>
-        <input type="text" id="ssid" placeholder="WiFi SSID" maxlength="31">
-
-        <label>Password:</label>
-        <input type="password" id="password" placeholder="WiFi Password (min 8 chars)\" minlength="8" maxlength="63">
-
-        <button onclick="updateWiFi()\">Save WiFi Settings</button>
-    </div>
-
-    <div id="status" class="status"></div>
-
-    <script>
-        // Sync time on page load
-        window.addEventListener('load', function() {
-            const now = new Date();
-            const hour = now.getHours();
-            const minute = now.getMinutes();
-            const second = now.getSeconds();
-
-            fetch('/api/time/sync?hour=' + hour + '&minute=' + minute + '&second=' + second, { method: 'POST' })
-                .then(r => r.json())
-                .then(d => console.log('Time synced with device'))
-                .catch(e => console.error('Time sync failed:', e));
-        });
-
-        function showStatus(message, isError) {
-            const status = document.getElementById('status');
-            status.textContent = message;
-            status.className = 'status ' + (isError ? 'error' : 'success');
-            status.style.display = 'block';
-            setTimeout(() => status.style.display = 'none', 5000);
-        }
-
-        function updateWiFi() {
-            const ssid = document.getElementById('ssid').value;
-            const password = document.getElementById('password').value;
-
-            if (!ssid || !password) {
-                showStatus('Please fill in both SSID and password', true);
-                return;
-            }
-
-            if (password.length < 8) {
-                showStatus('Password must be at least 8 characters', true);
-                return;
-            }
-
-            fetch('/api/wifi?ssid=' + encodeURIComponent(ssid) + '&password=' + encodeURIComponent(password), { method: 'POST' })
-                .then(r => r.json())
-                .then(d => {
-                    if (d.status === 'ok') {
-                        showStatus(d.message, false);
-                    } else {
-                        showStatus(d.message, true);
-                    }
-                })
-                .catch(e => showStatus('Error: ' + e, true));
-        }
-    </script>
-</body>
-</html>
-)";
-}
@@ -1,44 +1,305 @@
 #pragma once
 
 #include <WiFi.h>
-#include <WebServer.h>
+#include <esp_http_server.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
 #include "../Config.hpp"
 #include "../Types.hpp"
+#include "PerfProfiler.hpp"
+#include "LatencyTrace.hpp"
+#include "SeqLock.hpp"
+#include "RequestArgs.hpp"
+#include "SessionTokens.hpp"
+#include "TimeSync.hpp"
 
+class TimeKeeper;
+
+// HTTP front end on top of esp_http_server. The server runs its own
+// select()-driven task, so connections are multiplexed and kept alive
+// without a polling loop; handlers are static trampolines that recover
+// the manager from user_ctx.
 class WebServerManager {
 public:
     void init();
     void begin();
-    void handleClient();
 
     // Set callback for display control
-    void setDisplayControlCallback(void (*callback)(LED_PANEL_REQUEST));
+    void setDisplayControlCallback(SUBMIT_STATUS (*callback)(const LED_PANEL_REQUEST&));
+
+    // Set profiler served by /api/perf
+    void setProfiler(PerfProfiler* profiler);
+
+    // Set latency tracer (stamps requests, served by /api/trace)
+    void setLatencyTrace(LatencyTrace* trace);
+
+    // Set display state published by the display task (served by /api/state)
+    void setStateSnapshot(const SeqLock<DisplayStateSnapshot>* snapshot);
+
+    // Set clock disciplined by /api/time/sync (stats served by /api/time)
+    void setTimeSync(TimeSync* timeSync);
+
+    // Set ULP timekeeper (deep-sleep current estimates served by /api/time)
+    void setTimeKeeper(TimeKeeper* timeKeeper);
+
+    // Page statistics
+    uint32_t getPagesServed() const { return pagesServed; }
+    uint32_t getPagesNotModified() const { return pagesNotModified; }
+    uint32_t getPageBytesSent() const { return pageBytesSent; }
+
+    // /api/state read statistics
+    uint32_t getStateReads() const { return stateReads; }
+    uint32_t getStateNotModified() const { return stateNotModified; }
+
+    // WebSocket statistics: control messages received vs display submissions
+    uint32_t getWsMessages() const { return wsMessages; }
+    uint32_t getWsSubmitted() const { return wsSubmitted; }
+
+    // Largest drop in free heap across one handler call. Handlers keep
+    // nothing on the heap, so this should stay 0 apart from noise from
+    // other tasks allocating at the same moment.
+    uint32_t getHandlerHeapDeltaMax() const { return handlerHeapDeltaMax; }
+
+    // Cost of authorising one request (header lookup included), in CPU
+    // cycles of the server task's core
+    struct AuthStats {
+        uint32_t checks;
+        uint64_t totalCycles;
+        uint32_t maxCycles;
+
+        uint32_t avgCycles() const { return checks ? totalCycles / checks : 0; }
+    };
+    const AuthStats& getTokenAuthStats() const { return tokenAuth; }
+    const AuthStats& getBasicAuthStats() const { return basicAuth; }
+
+    // Display handoff statistics: submissions that had to wait for ring
+    // space, were merged into the overflow patch, or were turned away
+    uint32_t getSubmitWaited() const { return submitWaited; }
+    uint32_t getSubmitMerged() const { return submitMerged; }
+    uint32_t getSubmitRejected() const { return submitRejected; }
 
 private:
-    WebServer* server;
-    void (*displayControlCallback)(LED_PANEL_REQUEST);
+    httpd_handle_t server;
+    SUBMIT_STATUS (*displayControlCallback)(const LED_PANEL_REQUEST&);
+    PerfProfiler* profiler;
+    LatencyTrace* latencyTrace;
+    const SeqLock<DisplayStateSnapshot>* stateSnapshot;
+    TimeSync* timeSync;
+    TimeKeeper* timeKeeper;
+    uint32_t stateSequence;     // Last SET_STATE submission number
+    uint32_t stateReads;
+    uint32_t stateNotModified;
+    uint32_t handlerHeapDeltaMax;
+
+    // Colour/brightness changes that met a full display ring. They are
+    // merged here (last writer wins) and submitted as one SET_STATE once
+    // there is room; until then every other submission queues behind them
+    // so the display still sees changes in order.
+    DisplayStatePatch overflow;
+    uint32_t submitWaited;
+    uint32_t submitMerged;
+    uint32_t submitRejected;
+
+    // GET /api/state?wait= long-polls, and POST /api/state requests waiting
+    // for the display to apply them. The handler returns without replying
+    // and the response is written to the socket later from the server task.
+    struct StateWaiter {
+        WebServerManager* owner;
+        int fd;
+        uint32_t version;       // Version the client already has
+        uint32_t sequence;      // POST: submission awaited; 0 for a long-poll
+        int64_t deadlineUs;
+        bool active;
+    };
+    StateWaiter stateWaiters[STATE_MAX_WAITERS];
+    size_t stateWaiterCount;
+
+    // /ws control channel. Binary messages of WS_MESSAGE_SIZE bytes:
+    // [WS_ACTION][DISPLAY_FIELD][value, uint32 little-endian]. State changes
+    // are pushed to every client as the same JSON as GET /api/state.
+    enum WS_ACTION : uint8_t {
+        WS_SET = 1,     // Set `field` to `value`
+        WS_GET = 2      // Reply with the current state
+    };
+    static constexpr size_t WS_MESSAGE_SIZE = 6;
+    static constexpr size_t WS_MAX_MESSAGES_PER_FRAME = 8;
+
+    struct WsClient {
+        WebServerManager* owner;
+        int fd;
+        DisplayStatePatch pending;  // Fields received but not yet submitted
+        uint32_t inFlightSequence;  // Last submission, 0 if none
+        uint16_t traceId;           // Trace of the oldest pending change
+        bool active;
+    };
+    WsClient wsClients[WS_MAX_CLIENTS];
+    size_t wsClientCount;
+    uint32_t lastPushedVersion;
+    uint32_t wsMessages;
+    uint32_t wsSubmitted;
+
+    // Checks long-polls and WebSocket clients; runs only while either exists
+    esp_timer_handle_t pollTimer;
+    bool pollTimerRunning;
+
+    uint32_t pagesServed;
+    uint32_t pagesNotModified;
+    uint32_t pageBytesSent;
+
+    // Expected "Basic ..." Authorization header value, still accepted from
+    // scripts that send it up front
+    char authHeader[64];
+    size_t authHeaderLength;
+
+    // Issued by POST /api/login, presented as the "session" cookie or as
+    // "Authorization: Bearer <token>"
+    SessionTokens sessions;
+    AuthStats tokenAuth;
+    AuthStats basicAuth;
+
+    // Query string plus form body of the request being handled. The
+    // server task runs one handler at a time, so one buffer is enough.
+    char args[HTTP_ARGS_BUFFER_SIZE];
+
+    // Decoded views into args, filled by readArgs()
+    RequestArgs requestArgs;
+
+    // Scratch for /api/state: a snapshot copy and its JSON (text may be
+    // escaped up to six bytes per character). Other handlers build their
+    // responses in responseJson too rather than on the server task's stack.
+    DisplayStateSnapshot snapshot;
+    char responseJson[6 * MAX_HEADER_TEXT_LEN + 256];
 
     // WiFi AP configuration
     void initWiFiAP();
 
+    typedef esp_err_t (WebServerManager::*Handler)(httpd_req_t* req);
+
+    template<Handler handler>
+    static esp_err_t dispatch(httpd_req_t* req) {
+        WebServerManager* self = static_cast<WebServerManager*>(req->user_ctx);
+        size_t freeBefore = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+        esp_err_t result = (self->*handler)(req);
+        self->recordHeapDelta(freeBefore);
+        return result;
+    }
+
+    void recordHeapDelta(size_t freeBefore);
+
+    template<Handler handler>
+    void registerUri(const char* uri, httpd_method_t method);
+
+    static esp_err_t handleNotFound(httpd_req_t* req, httpd_err_code_t error);
+
     // HTTP request handlers
-    void handleRoot();
-    void handleUserControl();
-    void handleAdmin();
-    void handleNotFound();
+    esp_err_t handleRoot(httpd_req_t* req);
+    esp_err_t handleUserControl(httpd_req_t* req);
+    esp_err_t handleAdmin(httpd_req_t* req);
+    esp_err_t handleLogin(httpd_req_t* req);
+    esp_err_t handleNoContent(httpd_req_t* req);
 
     // API endpoints
-    void apiSetHeaderText();
-    void apiSetHeaderColor();
-    void apiSetTimeColor();
-    void apiSetBgColor();
-    void apiSetBrightness();
-    void apiSetDisplayPower();
-    void apiSyncTime();
-    void apiUpdateWiFiCredentials();
+    esp_err_t apiSetHeaderText(httpd_req_t* req);
+    esp_err_t apiSetHeaderColor(httpd_req_t* req);
+    esp_err_t apiSetTimeColor(httpd_req_t* req);
+    esp_err_t apiSetBgColor(httpd_req_t* req);
+    esp_err_t apiSetBrightness(httpd_req_t* req);
+    esp_err_t apiSetDisplayPower(httpd_req_t* req);
+    esp_err_t apiSyncTime(httpd_req_t* req);
+    esp_err_t apiGetTime(httpd_req_t* req);
+    esp_err_t apiUpdateWiFiCredentials(httpd_req_t* req);
+    esp_err_t apiGetPerf(httpd_req_t* req);
+    esp_err_t apiGetTrace(httpd_req_t* req);
+    esp_err_t apiSetState(httpd_req_t* req);
+    esp_err_t apiGetState(httpd_req_t* req);
+    esp_err_t apiLogin(httpd_req_t* req);
+    esp_err_t apiLogout(httpd_req_t* req);
+    esp_err_t handleWebSocket(httpd_req_t* req);
+
+    // One round of the page's NTP-style exchange: reply with our receive
+    // and send times, and turn the previous round (if given) into a sample
+    esp_err_t syncExchange(httpd_req_t* req, std::string_view t0Arg, int64_t receivedMs);
+
+    // Hand a request to the display, waiting up to DISPLAY_SUBMIT_WAIT_MS
+    // for ring space. Otherwise replies 202 if it was merged into the
+    // overflow patch, or 503 with Retry-After. False once a reply was sent.
+    bool submitRequest(httpd_req_t* req, LED_PANEL_REQUEST& request);
+
+    // Submit after any pending overflow, retrying a full ring for up to
+    // `waitMs`. SET_STATE requests get their sequence number stamped here.
+    SUBMIT_STATUS submit(LED_PANEL_REQUEST& request, uint32_t waitMs);
+
+    // Submit the overflow patch; true once nothing is pending
+    bool flushOverflow();
+
+    // Fold a fixed-size field change into the overflow patch; false for
+    // requests that cannot be merged
+    bool mergeOverflow(const LED_PANEL_REQUEST& request);
+
+    // Read the query string and any urlencoded body into args and parse
+    // them into requestArgs
+    bool readArgs(httpd_req_t* req);
+
+    // Append the request body to args after `used` bytes; replies 413 if it does not fit
+    bool receiveBody(httpd_req_t* req, size_t used);
+
+    // Look up an argument parsed by readArgs(); replies 400 "missing <key>" if absent
+    bool requireArg(httpd_req_t* req, const char* key, std::string_view& value);
+
+    esp_err_t sendJson(httpd_req_t* req, const char* status, const char* json);
+
+    // Reply {"status":"error","message":<message>}
+    esp_err_t sendError(httpd_req_t* req, const char* status, const char* message);
+
+    // Render `snapshot` into responseJson; returns the length (0 if it does not fit)
+    size_t formatState();
+
+    // Reply with `snapshot` as JSON, tagged with its version as the ETag
+    esp_err_t sendState(httpd_req_t* req, const char* status);
+    esp_err_t sendNotModified(httpd_req_t* req, uint32_t version);
+
+    // Outcome of SET_STATE submission `sequence` as of `state`
+    enum ApplyOutcome { APPLY_PENDING, APPLY_DONE, APPLY_REJECTED };
+    static ApplyOutcome applyOutcome(const DisplayStateSnapshot& state, uint32_t sequence);
+
+    // Long-poll bookkeeping
+    bool addStateWaiter(httpd_req_t* req, uint32_t version, uint32_t sequence, int64_t waitUs);
+    static void cancelStateWaiter(void* ctx);
+    static void onPollTimer(void* arg);
+    static void pollState(void* arg);
+    void updatePollTimer();
+    void sendRawState(int fd, const char* status);
+    void sendRawPending(int fd);
+    void sendRawNotModified(int fd);
+
+    // WebSocket bookkeeping
+    bool addWsClient(httpd_req_t* req);
+    static void closeWsClient(void* ctx);
+    void flushWsClient(WsClient& client);
+    void pollWebSockets();
+
+    // Send a pre-gzipped page straight from flash, or 304 if the
+    // client's If-None-Match already names this ETag
+    esp_err_t sendPage(httpd_req_t* req, const uint8_t* gz, size_t length, const char* etag);
 
     // Authentication
-    bool authenticate();
+    // True if the request carries a valid session token or Basic credentials
+    bool isAuthorized(httpd_req_t* req);
+
+    // isAuthorized(), replying 401 if not
+    bool authenticate(httpd_req_t* req);
+
+    // Find the session token in "Authorization: Bearer" or the "session"
+    // cookie; `token` points into `buffer`. If the Authorization header uses
+    // another scheme it is left in `buffer`, otherwise buffer[0] is '\0'.
+    bool findSessionToken(httpd_req_t* req, char* buffer, size_t size, const char*& token, size_t& length);
+
+    // Room for a Cookie header carrying other cookies besides ours
+    static constexpr size_t SESSION_HEADER_SIZE = 192;
+
+    static uint32_t nowSeconds();
+
+    esp_err_t redirect(httpd_req_t* req, const char* location);
 
     // WiFi credentials storage
     struct WiFiCredentials {
@@ -48,9 +309,4 @@ private:
 
     bool loadWiFiCredentials(WiFiCredentials& creds);
     bool saveWiFiCredentials(const WiFiCredentials& creds);
-
-    // HTML page generators
-    String generateLoginPage();
-    String generateUserControlPage();
-    String generateAdminPage();
-};
\ No newline at end of file
+};
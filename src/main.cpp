@@ -3,180 +3,393 @@
 #include <freertos/task.h>
 #include <freertos/queue.h>
 #include <freertos/semphr.h>
+#include <esp_timer.h>
+#include <esp_system.h>
 
 #include "components/TimeKeeper.hpp"
+#include "components/TimeSync.hpp"
 #include "components/DisplayManager.hpp"
 #include "components/WebServer.hpp"
 #include "components/SettingsStorage.hpp"
+#include "components/MessagePool.hpp"
+#include "components/CommandCoalescer.hpp"
+#include "components/SpscRing.hpp"
+#include "components/SeqLock.hpp"
+#include "components/PerfProfiler.hpp"
+#include "components/LatencyTrace.hpp"
+#include "components/SettingsWriteBehind.hpp"
+#include "components/SystemLogger.hpp"
+#include "components/Executor.hpp"
+#include "components/SecondTicker.hpp"
 #include "Types.hpp"
 
 // Component instances
 TimeKeeper timeKeeper;
+TimeSync timeSync;
 DisplayManager displayManager;
 WebServerManager webServer;
 SettingsStorage settingsStorage;
-
-// FreeRTOS queues and semaphores
-QueueHandle_t displayQueue;
+MessagePool messagePool;
+CommandCoalescer commandCoalescer;
+SettingsWriteBehind settingsWriteBehind;
+PerfProfiler perfProfiler;
+LatencyTrace latencyTrace;
+
+// Web -> display commands cross cores through a lock-free ring; the web task
+// is its only producer and the display task its only consumer
+SpscRing<MessageHandle, 16> displayRing;
+size_t displayRingHighWater = 0;    // Deepest the ring has been after a push
+uint32_t displayRingFull = 0;       // Pushes refused for lack of room
+
+// State published by other tasks and applied to LVGL by displayTask only
+SeqLock<ClockDisplayState> clockState;
+
+// Display settings as applied, owned by the display job and published for
+// /api/state after every change
+DisplayStateSnapshot displayState;
+SeqLock<DisplayStateSnapshot> stateSnapshot;
+
+// FreeRTOS queues and semaphores (queues carry MessageHandle into messagePool)
 QueueHandle_t storageQueue;
 SemaphoreHandle_t nvsMutex;
 
 // Display state
 bool displayPowerOn = true;
 
-// FreeRTOS task handles
-TaskHandle_t displayTaskHandle = NULL;
-TaskHandle_t webServerTaskHandle = NULL;
-TaskHandle_t timeUpdateTaskHandle = NULL;
-TaskHandle_t storageTaskHandle = NULL;
+// Run loops for the display, storage and time jobs. Task mode gives every
+// job its own loop, like the original dedicated tasks; executor mode shares
+// one loop per core and hands the reclaimed stack to the web server. The
+// core 1 loop only runs jobs that never wait: the NVS commit, the profiler
+// and the log drain go to the core 0 loop with the time job.
+Executor displayExecutor;
+#if LEDSTACK_EXECUTOR_MODE
+Executor& storageExecutor = displayExecutor;   // Core 1
+#else
+Executor storageExecutor;
+#endif
+Executor timeExecutor;                         // Core 0
+
+int displayJobId = -1;
+int storageJobId = -1;
+int timeJobId = -1;
 
+// Publishes the clock on every second boundary of timeSync, from a one-shot
+// esp_timer it re-arms each time
+SecondTicker secondTicker;
+esp_timer_handle_t clockTimer;
 
-void displayTask(void* parameter) 
+
+// Mirror an applied request into displayState (published by the caller)
+void recordState(const LED_PANEL_REQUEST& req) 
 {
-    const TickType_t xDelay = pdMS_TO_TICKS(5); 
-
-    while (true) {
-        LED_PANEL_REQUEST req;
-        if (xQueueReceive(displayQueue, &req, 0) == pdTRUE) {
-            displayManager.handleRequest(req);
-
-            // Handle time sync separately
-            if (req.action == SET_TIME_DATA) {
-                timeKeeper.setTime(req.data.timeData.hour,
-                                  req.data.timeData.minute,
-                                  req.data.timeData.second);
-                Serial.printf("Time synced: %02d:%02d:%02d\n",
-                             req.data.timeData.hour,
-                             req.data.timeData.minute,
-                             req.data.timeData.second);
-            }else if (xQueueSend(storageQueue, &req, 0) == pdTRUE)
-                Serial.println("Message sent to Storage from Display Manager");
+    switch (req.action) {
+        case SET_HEADER_T:
+            strncpy(displayState.headerText, req.data.text, MAX_HEADER_TEXT_LEN);
+            displayState.headerText[MAX_HEADER_TEXT_LEN] = '\0';
+            break;
+        case SET_HEADER_COL:
+            displayState.headerColor = req.data.color;
+            break;
+        case SET_TIME_COL:
+            displayState.timeColor = req.data.color;
+            break;
+        case SET_BG_COL:
+            displayState.bgColor = req.data.color;
+            break;
+        case SET_LED_BRIGHT:
+            displayState.brightness = req.data.brightness;
+            break;
+        case SET_STATE: {
+            const DisplayStatePatch& patch = req.data.state;
+            if (patch.fields & FIELD_HEADER_TEXT) {
+                strncpy(displayState.headerText, patch.headerText, MAX_HEADER_TEXT_LEN);
+                displayState.headerText[MAX_HEADER_TEXT_LEN] = '\0';
+            }
+            if (patch.fields & FIELD_HEADER_COLOR) displayState.headerColor = patch.headerColor;
+            if (patch.fields & FIELD_TIME_COLOR)   displayState.timeColor = patch.timeColor;
+            if (patch.fields & FIELD_BG_COLOR)     displayState.bgColor = patch.bgColor;
+            if (patch.fields & FIELD_BRIGHTNESS)   displayState.brightness = patch.brightness;
+            break;
         }
+        default:
+            return;
+    }
+}
 
-        displayManager.update();
-        displayManager.lvglTick();
-
-        vTaskDelay(xDelay);
+// Storage shares the same payload; it releases its reference when done
+void persistRequest(MessageHandle handle) 
+{
+    messagePool.retain(handle);
+    if (xQueueSend(storageQueue, &handle, 0) != pdTRUE) {
+        messagePool.release(handle);
+        LOG_W(APP, "Storage queue full - setting not persisted");
     }
 }
 
-void storageTask(void* parameter) 
+// Versions are never 0, which If-Match and If-None-Match use for "none"
+void bumpStateVersion() 
 {
-    const TickType_t xDelay = pdMS_TO_TICKS(1000);
-
-    while (true) {
-        LED_PANEL_REQUEST req;
-
-        if (xQueueReceive(storageQueue, &req, 0) == pdTRUE) {
-            if (xSemaphoreTake(nvsMutex, portMAX_DELAY) == pdTRUE) {
-                switch (req.action) {
-                    case SET_HEADER_T:
-                        settingsStorage.saveHeaderText(req.data.text);
-                        Serial.println("Storage: Saved header text");
-                        break;
-                    case SET_HEADER_COL:
-                        settingsStorage.saveHeaderColor(req.data.color);
-                        Serial.println("Storage: Saved header color");
-                        break;
-                    case SET_TIME_COL:
-                        settingsStorage.saveTimeColor(req.data.color);
-                        Serial.println("Storage: Saved time color");
-                        break;
-                    case SET_BG_COL:
-                        settingsStorage.saveBgColor(req.data.color);
-                        Serial.println("Storage: Saved background color");
-                        break;
-                    case SET_LED_BRIGHT:
-                        settingsStorage.saveBrightness(req.data.brightness);
-                        Serial.println("Storage: Saved brightness");
-                        break;
-                    default:
-                        break;
-                }
-                xSemaphoreGive(nvsMutex);
-            }
-        }
-        vTaskDelay(xDelay);
+    if (++displayState.version == 0) {
+        displayState.version = 1;
     }
 }
 
-void webServerTask(void* parameter) 
+void applyCoalescedRequests() 
 {
-    const TickType_t xDelay = pdMS_TO_TICKS(2); 
+    uint8_t dirty = commandCoalescer.getDirtyFields();
+
+    for (uint8_t bit = 0; bit < CommandCoalescer::FIELD_COUNT; bit++) {
+        DISPLAY_FIELD field = (DISPLAY_FIELD)(1 << bit);
+        if (!(dirty & field)) continue;
+
+        MessageHandle handle = commandCoalescer.getPending(field);
+        const LED_PANEL_REQUEST& req = messagePool.get(handle);
 
-    while (true) {
-        webServer.handleClient();
-        vTaskDelay(xDelay);
+        displayManager.handleRequest(req);
+        latencyTrace.record(req.traceId, TRACE_INVALIDATED);
+        displayManager.traceNextFlush(req.traceId);
+        recordState(req);
+
+        if (field & FIELD_PERSISTENT_MASK) {
+            persistRequest(handle);
+        }
     }
+
+    commandCoalescer.clear();
+
+    bumpStateVersion();
+    stateSnapshot.publish(displayState);
+
+    LOG_D(APP, "Display update applied (received=%u, coalesced=%u)",
+          commandCoalescer.getReceivedCount(),
+          commandCoalescer.getCoalescedCount());
 }
 
-void timeUpdateTask(void* parameter) 
+// Apply a SET_STATE batch as one update and one persistence request, unless
+// its If-Match version is stale. Takes over the caller's pool reference.
+void applyStateRequest(MessageHandle handle) 
 {
-    const TickType_t xDelay = pdMS_TO_TICKS(1000); 
-    char timeBuffer[16];
-    bool showColon = true;
+    const LED_PANEL_REQUEST& req = messagePool.get(handle);
+    const DisplayStatePatch& patch = req.data.state;
+
+    // Shift the outcome history up to this submission; numbers skipped by
+    // merged submissions count as applied
+    uint32_t advance = patch.sequence - displayState.appliedSequence;
+    displayState.rejectedMask = advance < 32 ? displayState.rejectedMask << advance : 0;
+
+    if (patch.ifMatch != 0 && patch.ifMatch != displayState.version) {
+        displayState.rejectedMask |= 1;
+        latencyTrace.record(req.traceId, TRACE_DROPPED);
+        LOG_W(APP, "State update rejected: If-Match %u, current version %u",
+                   patch.ifMatch, displayState.version);
+    } else if (patch.fields) {
+        displayManager.handleRequest(req);
+        latencyTrace.record(req.traceId, TRACE_INVALIDATED);
+        displayManager.traceNextFlush(req.traceId);
+        recordState(req);
+        bumpStateVersion();
+
+        if (patch.fields & FIELD_PERSISTENT_MASK) {
+            persistRequest(handle);
+        }
+    }
 
-    while (true) {
-        int gpio_level = rtc_gpio_get_level(GPIO_NUM_32);
-        PowerStatus powerStatus = gpio_level ? MAIN_POWER : BATTERY_POWER;
+    displayState.appliedSequence = patch.sequence;
+    stateSnapshot.publish(displayState);
+    messagePool.release(handle);
+}
 
-        TimeData currentTime = timeKeeper.getCurrentTime();
+void applyPublishedState() 
+{
+    static uint32_t appliedClockVersion = 0;
 
-        if (powerStatus == BATTERY_POWER) {
-            Serial.println("Battery detected - entering deep sleep (ULP will handle time/wake)");
-            timeKeeper.enterDeepSleep();
+    if (clockState.version() != appliedClockVersion) {
+        ClockDisplayState clock;
+        appliedClockVersion = clockState.read(clock);
+        displayManager.setTimeText(clock.timeText);
+    }
+}
+
+// One display frame: apply pending commands and published state, then render
+void displayJob() 
+{
+    // Power is failing: the panel stays off until deep sleep
+    if (displayManager.blankIfRequested()) return;
+
+    // Drain everything queued since the last frame, keeping only the
+    // latest request per field, then render once
+    MessageHandle handle;
+    while (displayRing.pop(handle)) {
+        latencyTrace.record(messagePool.get(handle).traceId, TRACE_DEQUEUED);
+
+        // Batches are applied whole, after anything queued before them
+        if (messagePool.get(handle).action == SET_STATE) {
+            if (commandCoalescer.hasPending()) {
+                applyCoalescedRequests();
+            }
+            applyStateRequest(handle);
+            continue;
         }
 
-        // Convert to 12-hour format for display
-        uint8_t displayHour = currentTime.hour;
-        if (displayHour == 0) {
-            displayHour = 12; // Midnight
-        } else if (displayHour > 12) {
-            displayHour -= 12; // PM hours
+        // A superseded request is never applied; end its trace here
+        DISPLAY_FIELD field = CommandCoalescer::fieldForAction(messagePool.get(handle).action);
+        if (commandCoalescer.getDirtyFields() & field) {
+            latencyTrace.record(messagePool.get(commandCoalescer.getPending(field)).traceId, TRACE_DROPPED);
         }
+        commandCoalescer.merge(handle);
+    }
 
-        // Format time with pulsing colon (alternates every second)
-        const char* separator = showColon ? ":" : " ";
-        snprintf(timeBuffer, sizeof(timeBuffer), "%02d%s%02d",
-                 displayHour, separator, currentTime.minute);
+    if (commandCoalescer.hasPending()) {
+        applyCoalescedRequests();
+    }
 
-        showColon = !showColon; // Toggle for next iteration
+    // LVGL is only touched from this job, once per frame
+    applyPublishedState();
 
-        LED_PANEL_REQUEST req;
-        req.action = SET_TIME_T;
-        strncpy(req.data.text, timeBuffer, sizeof(req.data.text) - 1);
-        req.data.text[sizeof(req.data.text) - 1] = '\0';
+    displayManager.update();
+    displayManager.lvglTick();
+}
 
-        displayManager.setTimeText(req.data.text);
-        //xQueueSend(displayQueue, &req, portMAX_DELAY);
+void storageJob() 
+{
+    MessageHandle handle;
+
+    // Merge changes into the write-behind cache; it commits them in one
+    // NVS transaction once the user stops making changes. While a commit
+    // holds the cache the rest stay queued for the next run.
+    while (xQueuePeek(storageQueue, &handle, 0) == pdTRUE) {
+        if (!settingsWriteBehind.markDirty(messagePool.get(handle))) break;
+        xQueueReceive(storageQueue, &handle, 0);
+        messagePool.release(handle);
+    }
 
-        vTaskDelay(xDelay);
+#if !LEDSTACK_EXECUTOR_MODE
+    settingsWriteBehind.flushIfQuiet();
+#endif
+}
+
+#if LEDSTACK_EXECUTOR_MODE
+// The NVS commit (tens of ms of flash erase/write) runs on the core 0 loop
+// so it never holds up the 5 ms display job sharing the core 1 loop
+void commitJob() 
+{
+    settingsWriteBehind.flushIfQuiet();
+}
+#endif
+
+// Runs on the esp_timer task at each second boundary of timeSync
+void publishClock(int64_t second) 
+{
+    ClockDisplayState clock;
+    Calendar::DateTime now = Calendar::fromEpoch((uint32_t)second);
+
+    // Convert to 12-hour format for display
+    uint8_t displayHour = now.hour;
+    if (displayHour == 0) {
+        displayHour = 12; // Midnight
+    } else if (displayHour > 12) {
+        displayHour -= 12; // PM hours
+    }
+
+    // Pulsing colon, shown on even seconds
+    const char* separator = (second % 2 == 0) ? ":" : " ";
+    snprintf(clock.timeText, sizeof(clock.timeText), "%02d%s%02d",
+             displayHour, separator, now.minute);
+
+    // Publish only; the display job applies it to LVGL on its next frame
+    clockState.publish(clock);
+}
+
+void timeUpdateJob() 
+{
+    // The display follows the disciplined clock (publishClock); the ULP
+    // counters only carry time through deep sleep, so pull them back when
+    // they wander
+    uint32_t corrected;
+    if (timeSync.checkUlpTime(timeKeeper.getEpoch(), corrected)) {
+        timeKeeper.setEpoch(corrected);
+        LOG_I(APP, "ULP time corrected to epoch %u", corrected);
     }
+
+    timeKeeper.updateCalibration();
 }
 
-void webServerDisplayCallback(LED_PANEL_REQUEST req) 
+// Runs on the power monitor task once a power failure is confirmed, right
+// before deep sleep; the time spent here is reported after the next wake.
+// The panel belongs to the display task, so it is asked to blank it first,
+// as it draws the most from the battery. Settings are flushed only if the
+// commit fits in what is left of POWER_FAIL_BUDGET_US; otherwise the last
+// changes are lost rather than the sleep delayed.
+void powerLossCallback() 
 {
-    Serial.println("Web server callback polled");
-    xQueueSend(displayQueue, &req, portMAX_DELAY);
+    int64_t start = esp_timer_get_time();
+
+    displayManager.requestBlank();
+    displayExecutor.trigger(displayJobId);
+    while (!displayManager.isBlanked() && esp_timer_get_time() - start < POWER_FAIL_BLANK_WAIT_US) {
+        vTaskDelay(1);
+    }
+
+    int64_t leftUs = POWER_FAIL_BUDGET_US - (esp_timer_get_time() - start);
+    settingsWriteBehind.flush(leftUs > 0 ? (uint32_t)leftUs : 0);
+}
+
+SUBMIT_STATUS webServerDisplayCallback(const LED_PANEL_REQUEST& req) 
+{
+    MessageHandle handle = messagePool.allocate(req);
+    if (handle == INVALID_MESSAGE) {
+        // Draining the ring frees slots for the caller's retry
+        displayExecutor.trigger(displayJobId);
+        return SUBMIT_BUSY;
+    }
+
+    if (!displayRing.push(handle)) {
+        messagePool.release(handle);
+        displayRingFull++;
+        displayExecutor.trigger(displayJobId);
+        return SUBMIT_BUSY;
+    }
+
+    size_t depth = displayRing.size();
+    if (depth > displayRingHighWater) displayRingHighWater = depth;
+
+    // Doorbell: run the display job now instead of waiting for its next frame
+    displayExecutor.trigger(displayJobId);
+    return SUBMIT_OK;
 }
 
 
 void setup() 
 {
+    // Hot paths log through the async logger; records are buffered until
+    // its drain task starts
+    systemLogger.init();
+
 #ifdef DEBUG_LEDSTACK
     Serial.begin(115200);
     delay(1000);
+#else
+    if (SystemLogger::ENABLED) Serial.begin(115200);
+#endif
+    // Drained in every build that logs at all, so records are printed
+    // rather than counted as dropped once the ring fills (by the core 0
+    // loop's log job in executor mode)
+#if !LEDSTACK_EXECUTOR_MODE
+    if (SystemLogger::ENABLED) systemLogger.start();
+#endif
+
+#ifdef DEBUG_LEDSTACK
 
     Serial.println("========================================");
     Serial.println("ledStack Initializing...");
     Serial.println("========================================");
 #endif
 
-    displayQueue = xQueueCreate(10, sizeof(LED_PANEL_REQUEST));
-    storageQueue = xQueueCreate(10, sizeof(LED_PANEL_REQUEST)); 
+    messagePool.init();
+    storageQueue = xQueueCreate(10, sizeof(MessageHandle)); 
     nvsMutex = xSemaphoreCreateMutex();
 
-    if (displayQueue == NULL || storageQueue == NULL || nvsMutex == NULL) {
+    if (storageQueue == NULL || nvsMutex == NULL) {
 #ifdef DEBUG_LEDSTACK
         Serial.println("Failed to create queue/mutex");
 #endif
@@ -187,17 +400,26 @@ void setup()
     Serial.println("Initializing Settings Storage...");
 #endif
     settingsStorage.init();
+    settingsWriteBehind.init(&settingsStorage, nvsMutex);
+    commandCoalescer.init(&messagePool);
 
 #ifdef DEBUG_LEDSTACK
     Serial.println("Initializing TimeKeeper...");
 #endif
     timeKeeper.init();
+    timeKeeper.setPowerLossCallback(powerLossCallback);
+    timeSync.init(timeKeeper.getEpoch());
 
 #ifdef DEBUG_LEDSTACK
-    if (timeKeeper.wasWokenByULP()) {
-        Serial.println("Woken by ULP - Main power restored");
+    if (timeKeeper.wasWokenByPowerRestore()) {
+        Serial.println("Woken by GPIO 32 - Main power restored");
     }
 #endif
+    TimeKeeper::PowerFailTiming powerFail = timeKeeper.getLastPowerFail();
+    if (powerFail.toSleepUs) {
+        LOG_I(APP, "Last power fail: debounce %u us, flush %u us, edge to sleep %u us",
+              powerFail.debounceUs, powerFail.callbackUs, powerFail.toSleepUs);
+    }
 
     PowerStatus powerStatus = timeKeeper.getPowerStatus();
 #ifdef DEBUG_LEDSTACK
@@ -215,13 +437,15 @@ void setup()
     Serial.println("Initializing Display...");
 #endif
 
+    latencyTrace.init();
     displayManager.init();
+    displayManager.setLatencyTrace(&latencyTrace);
 
 #ifdef DEBUG_LEDSTACK
     Serial.println("Loading saved settings...");
 #endif
 
-    DisplaySettings settings;
+    DisplaySettings settings = { 255, 0x0000FF, 0xFFFFFF, 0x000000, "ledStack" };
     if (settingsStorage.loadSettings(settings)) {
         displayManager.setBrightness(settings.brightness);
         displayManager.setHeaderText(settings.headerText);
@@ -239,59 +463,137 @@ void setup()
     Serial.println("Initializing WebServer...");
 #endif
 
+    // Initial state for /api/state; the display job publishes from here on.
+    // The version starts at a random nonzero value, so an ETag a client kept
+    // from before a reboot does not match (a false 304 or a long-poll that
+    // never wakes) when the counter restarts.
+    displayState.version = esp_random() | 1;
+    displayState.brightness = settings.brightness;
+    displayState.headerColor = settings.headerColor;
+    displayState.timeColor = settings.timeColor;
+    displayState.bgColor = settings.bgColor;
+    strncpy(displayState.headerText, settings.headerText, MAX_HEADER_TEXT_LEN);
+    stateSnapshot.publish(displayState);
+
     webServer.init();
     webServer.setDisplayControlCallback(webServerDisplayCallback);
+    webServer.setProfiler(&perfProfiler);
+    webServer.setLatencyTrace(&latencyTrace);
+    webServer.setStateSnapshot(&stateSnapshot);
+    webServer.setTimeSync(&timeSync);
+    webServer.setTimeKeeper(&timeKeeper);
     webServer.begin();
+    timeSync.startSntp(TIME_SYNC_SNTP_SERVER, TIME_SYNC_SNTP_INTERVAL_S);
 
 #ifdef DEBUG_LEDSTACK
     Serial.println("Creating FreeRTOS tasks...");
 #endif
 
-    xTaskCreatePinnedToCore(
-        displayTask,
-        "DisplayTask",
-        8192,  
-        NULL,
-        3,  
-        &displayTaskHandle,
-        1     
-    );
-
-    xTaskCreatePinnedToCore(
-        webServerTask,
-        "WebServerTask",
-        8192,
-        NULL,
-        10,
-        &webServerTaskHandle,
-        0     
-    );
-
-    xTaskCreatePinnedToCore(
-        timeUpdateTask,
-        "TimeUpdateTask",
-        4096,
-        NULL,
-        2,
-        &timeUpdateTaskHandle,
-        0     
-    );
-
-    xTaskCreatePinnedToCore(
-        storageTask,
-        "StorageTask",
-        4096,
-        NULL,
-        1,    
-        &storageTaskHandle,
-        1      
-    );
+    esp_timer_create_args_t clockTimerArgs = {};
+    clockTimerArgs.callback = [](void*) { secondTicker.fire(); };
+    clockTimerArgs.name = "clock";
+    esp_timer_create(&clockTimerArgs, &clockTimer);
+    secondTicker.init([]() { return timeSync.nowUs(); },
+                      [](uint64_t delayUs) { esp_timer_start_once(clockTimer, delayUs); },
+                      publishClock, TIME_SYNC_SLEW_PPM);
+    secondTicker.start();
+
+#if LEDSTACK_EXECUTOR_MODE
+    displayExecutor.init("Core1Loop");
+    timeExecutor.init("Core0Loop");
+#else
+    displayExecutor.init("DisplayTask");
+    storageExecutor.init("StorageTask");
+    timeExecutor.init("TimeUpdateTask");
+#endif
+    displayJobId = displayExecutor.addJob("display", displayJob, 5);
+    storageJobId = storageExecutor.addJob("storage", storageJob, 250);
+    timeJobId = timeExecutor.addJob("time", timeUpdateJob, 1000);
+#if LEDSTACK_EXECUTOR_MODE
+    timeExecutor.addJob("commit", commitJob, 250);
+    timeExecutor.addJob("perf", []() { perfProfiler.tick(); }, PERF_SAMPLE_PERIOD_MS);
+    if (SystemLogger::ENABLED) {
+        timeExecutor.addJob("log", []() { systemLogger.drain(); }, LOG_DRAIN_PERIOD_MS);
+    }
+#endif
+
+    // Before the first profiler job can run
+    perfProfiler.init();
+
+    // Core 0 loop stack: each of its jobs ran in at most 4096 bytes as a
+    // task of its own, and jobs run one at a time
+    displayExecutor.start(8192, 3, 1);
+    timeExecutor.start(4096, 2, 0);
+#if !LEDSTACK_EXECUTOR_MODE
+    storageExecutor.start(4096, 1, 1);
+#endif
+
+    // Main power was present at the boot check above; from here a drop is
+    // caught by the power sense pin's falling edge
+    timeKeeper.startPowerMonitor();
+
+    perfProfiler.registerCounter("display_received", []() { return commandCoalescer.getReceivedCount(); });
+    perfProfiler.registerCounter("display_coalesced", []() { return commandCoalescer.getCoalescedCount(); });
+    perfProfiler.registerCounter("pool_high_water", []() { return (uint32_t)messagePool.getHighWater(); });
+    perfProfiler.registerCounter("pool_alloc_failures", []() { return messagePool.getAllocFailures(); });
+    perfProfiler.registerCounter("pool_allocs", []() { return messagePool.getAllocCount(); });
+    perfProfiler.registerCounter("pool_bytes_copied", []() { return messagePool.getBytesCopied(); });
+    perfProfiler.registerCounter("display_ring_depth", []() { return (uint32_t)displayRing.size(); });
+    perfProfiler.registerCounter("display_ring_high_water", []() { return (uint32_t)displayRingHighWater; });
+    perfProfiler.registerCounter("display_ring_full", []() { return displayRingFull; });
+    perfProfiler.registerCounter("web_submit_waited", []() { return webServer.getSubmitWaited(); });
+    perfProfiler.registerCounter("web_submit_merged", []() { return webServer.getSubmitMerged(); });
+    perfProfiler.registerCounter("web_submit_rejected", []() { return webServer.getSubmitRejected(); });
+    perfProfiler.registerCounter("nvs_commits", []() { return settingsStorage.getCommitCount(); });
+    perfProfiler.registerCounter("nvs_bytes_written", []() { return settingsStorage.getBytesWritten(); });
+    perfProfiler.registerCounter("web_pages_served", []() { return webServer.getPagesServed(); });
+    perfProfiler.registerCounter("web_pages_not_modified", []() { return webServer.getPagesNotModified(); });
+    perfProfiler.registerCounter("web_page_bytes_sent", []() { return webServer.getPageBytesSent(); });
+    perfProfiler.registerCounter("state_reads", []() { return webServer.getStateReads(); });
+    perfProfiler.registerCounter("state_not_modified", []() { return webServer.getStateNotModified(); });
+    perfProfiler.registerCounter("ws_messages", []() { return webServer.getWsMessages(); });
+    perfProfiler.registerCounter("ws_submitted", []() { return webServer.getWsSubmitted(); });
+    perfProfiler.registerCounter("http_heap_delta_max", []() { return webServer.getHandlerHeapDeltaMax(); });
+    perfProfiler.registerCounter("auth_token_checks", []() { return webServer.getTokenAuthStats().checks; });
+    perfProfiler.registerCounter("auth_token_avg_cycles", []() { return webServer.getTokenAuthStats().avgCycles(); });
+    perfProfiler.registerCounter("auth_token_max_cycles", []() { return webServer.getTokenAuthStats().maxCycles; });
+    perfProfiler.registerCounter("auth_basic_checks", []() { return webServer.getBasicAuthStats().checks; });
+    perfProfiler.registerCounter("auth_basic_avg_cycles", []() { return webServer.getBasicAuthStats().avgCycles(); });
+    perfProfiler.registerCounter("auth_basic_max_cycles", []() { return webServer.getBasicAuthStats().maxCycles; });
+    perfProfiler.registerCounter("rtc_slow_clock_millihz", []() { return timeKeeper.getSlowClockMilliHz(); });
+    perfProfiler.registerCounter("rtc_calibrations", []() { return timeKeeper.getCalibrationCount(); });
+    perfProfiler.registerCounter("log_dropped", []() { return systemLogger.getDropped(); });
+    perfProfiler.registerCounter("log_avg_cycles", []() { return systemLogger.getAvgCycles(); });
+    perfProfiler.registerCounter("log_max_cycles", []() { return systemLogger.getMaxCycles(); });
+    perfProfiler.registerCounter("executor_mode", []() { return (uint32_t)LEDSTACK_EXECUTOR_MODE; });
+    perfProfiler.registerCounter("job_display_late_max_us", []() { return displayExecutor.getJobStats(displayJobId).maxLatenessUs; });
+    perfProfiler.registerCounter("job_display_late_avg_us", []() { return displayExecutor.getJobStats(displayJobId).avgLatenessUs; });
+    perfProfiler.registerCounter("job_storage_late_max_us", []() { return storageExecutor.getJobStats(storageJobId).maxLatenessUs; });
+    perfProfiler.registerCounter("job_display_run_max_us", []() { return displayExecutor.getJobStats(displayJobId).maxRunUs; });
+    perfProfiler.registerCounter("job_storage_run_max_us", []() { return storageExecutor.getJobStats(storageJobId).maxRunUs; });
+    perfProfiler.registerCounter("job_time_late_max_us", []() { return timeExecutor.getJobStats(timeJobId).maxLatenessUs; });
+    perfProfiler.registerCounter("settings_deferred", []() { return settingsWriteBehind.getDeferred(); });
+    perfProfiler.registerCounter("settings_save_max_us", []() { return settingsStorage.getMaxSaveUs(); });
+    perfProfiler.registerCounter("clock_ticks", []() { return secondTicker.getStats().ticks; });
+    perfProfiler.registerCounter("clock_late_avg_us", []() { return secondTicker.getStats().avgLatenessUs; });
+    perfProfiler.registerCounter("clock_late_max_us", []() { return secondTicker.getStats().maxLatenessUs; });
+    perfProfiler.registerCounter("clock_late_missed", []() { return secondTicker.getStats().missed; });
+    perfProfiler.registerCounter("clock_rearms", []() { return secondTicker.getStats().rearms; });
+    perfProfiler.registerCounter("clock_jumps", []() { return secondTicker.getStats().jumps; });
+    perfProfiler.registerCounter("power_fail_to_sleep_us", []() { return timeKeeper.getLastPowerFail().toSleepUs; });
+    perfProfiler.registerCounter("power_glitches", []() { return timeKeeper.getPowerGlitches(); });
+#if !LEDSTACK_EXECUTOR_MODE
+    perfProfiler.start();
+#endif
 
 #ifdef DEBUG_LEDSTACK
     Serial.println("========================================");
     Serial.println("ledStack Initialized Successfully");
     Serial.println("========================================");
-    Serial.printf("Free heap: %d bytes\n", ESP.getFreeHeap());
+    Serial.printf("Free heap: %d bytes (%s mode)\n", ESP.getFreeHeap(),
+                  LEDSTACK_EXECUTOR_MODE ? "executor" : "task");
+    Serial.printf("Request memory: ring=%u bytes, queue=%u bytes, pool=%u bytes\n",
+                  sizeof(displayRing), 10 * sizeof(MessageHandle), sizeof(MessagePool));
 #endif
 }
 
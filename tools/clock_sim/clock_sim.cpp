@@ -0,0 +1,252 @@
+// Runs the second-boundary scheduler (src/components/SecondTicker.cpp)
+// against a mock wall clock and one-shot timer, and checks that every
+// second is published once, in order, within SecondTicker::MISS_US of its
+// boundary while the clock is slewed and stepped.
+//
+// Build and run from the repository root:
+//   g++ -std=gnu++17 -O2 -Isrc/components tools/clock_sim/clock_sim.cpp
+//       src/components/SecondTicker.cpp -o clock_sim && ./clock_sim
+//
+// Prints one line per scenario and exits non-zero if any fails.
+
+#include <stdio.h>
+#include "SecondTicker.hpp"
+
+static constexpr int64_t US_PER_S = 1000000;
+
+// TimeSync slews at up to TIME_SYNC_SLEW_PPM (Config.hpp)
+static constexpr uint32_t SLEW_PPM = 5000;
+
+// Mock time. The timer runs on the monotonic clock (esp_timer); the wall
+// clock follows it at `ratePpm` from `wallBase` onwards, like TimeSync's
+// offset while a slew is in progress.
+static int64_t monotonicUs;
+static int64_t monotonicBase;
+static int64_t wallBase;
+static int32_t ratePpm;
+
+static bool timerArmed;
+static int64_t timerDeadline;
+static uint32_t maxDispatchUs;      // esp_timer task latency, drawn per firing
+static uint32_t randomState = 1;
+static uint32_t jobUs;              // How long the job runs
+
+// What the job saw
+static int64_t lastPublished;
+static int64_t lastLatenessUs;
+static uint32_t published;
+
+static SecondTicker ticker;
+
+static int failures = 0;
+
+#define CHECK(condition, ...)                                   \
+    do {                                                        \
+        if (!(condition)) {                                     \
+            printf("  %s:%d: %s: ", __FILE__, __LINE__, #condition); \
+            printf(__VA_ARGS__);                                \
+            printf("\n");                                       \
+            return false;                                       \
+        }                                                       \
+    } while (0)
+
+static uint32_t nextRandom() {
+    randomState = randomState * 1103515245 + 12345;
+    return randomState >> 8;
+}
+
+static int64_t floorDiv(int64_t value, int64_t divisor) {
+    int64_t quotient = value / divisor;
+    return (value % divisor < 0) ? quotient - 1 : quotient;
+}
+
+static int64_t wallClock() {
+    int64_t elapsed = monotonicUs - monotonicBase;
+    return wallBase + elapsed + elapsed * ratePpm / US_PER_S;
+}
+
+static void setRate(int32_t ppm) {
+    wallBase = wallClock();
+    monotonicBase = monotonicUs;
+    ratePpm = ppm;
+}
+
+static void step(int64_t deltaUs) {
+    wallBase += deltaUs;
+}
+
+static void armTimer(uint64_t delayUs) {
+    timerArmed = true;
+    timerDeadline = monotonicUs + (int64_t)delayUs + (maxDispatchUs ? nextRandom() % (maxDispatchUs + 1) : 0);
+}
+
+static void publish(int64_t second) {
+    lastPublished = second;
+    lastLatenessUs = wallClock() - second * US_PER_S;
+    published++;
+    monotonicUs += jobUs;
+}
+
+static void reset(int64_t wallStartUs, uint32_t dispatchUs) {
+    monotonicUs = 0;
+    monotonicBase = 0;
+    wallBase = wallStartUs;
+    ratePpm = 0;
+    timerArmed = false;
+    maxDispatchUs = dispatchUs;
+    jobUs = 20;
+    published = 0;
+    ticker.init(wallClock, armTimer, publish, SLEW_PPM);
+    ticker.start();
+}
+
+// Advance the mock clocks to the next timer firing and run it
+static bool fireNext() {
+    if (!timerArmed) {
+        printf("  timer not armed after tick %u\n", published);
+        return false;
+    }
+    monotonicUs = timerDeadline;
+    timerArmed = false;
+    ticker.fire();
+    return true;
+}
+
+// Fire until the job runs, passing over early firings
+static bool fireUntilPublished() {
+    uint32_t count = published;
+    while (published == count) {
+        if (!fireNext()) return false;
+    }
+    return true;
+}
+
+// Run until `seconds` more seconds have been published, each the one after
+// the last and started within MISS_US of its boundary
+static bool runOnTime(uint32_t seconds) {
+    uint32_t target = published + seconds;
+    while (published < target) {
+        int64_t before = lastPublished;
+        uint32_t count = published;
+        if (!fireNext()) return false;
+        if (published == count) continue;   // Early firing armed again
+
+        CHECK(lastPublished == before + 1, "published %lld after %lld", (long long)lastPublished, (long long)before);
+        CHECK(lastLatenessUs >= 0 && lastLatenessUs < SecondTicker::MISS_US,
+              "second %lld started %lld us after its boundary", (long long)lastPublished, (long long)lastLatenessUs);
+    }
+    return true;
+}
+
+static void report() {
+    SecondTicker::Stats stats = ticker.getStats();
+    printf("  %u ticks: lateness avg %u us, max %u us, %u missed, %.2f rearms per tick, %u jumps\n",
+           stats.ticks, stats.avgLatenessUs, stats.maxLatenessUs, stats.missed,
+           (double)stats.rearms / stats.ticks, stats.jumps);
+}
+
+static bool startsImmediately() {
+    reset(1767268800LL * US_PER_S + 123456, 0);
+    CHECK(published == 1 && lastPublished == 1767268800LL, "published %u, second %lld", published, (long long)lastPublished);
+    CHECK(timerArmed, "no timer armed");
+    return runOnTime(5);
+}
+
+static bool steadyDay() {
+    reset(1767268800LL * US_PER_S + 700000, 300);
+    if (!runOnTime(86400)) return false;
+
+    SecondTicker::Stats stats = ticker.getStats();
+    CHECK(stats.missed == 0 && stats.jumps == 0, "%u missed, %u jumps", stats.missed, stats.jumps);
+    CHECK(lastLatenessUs == (int64_t)stats.lastLatenessUs, "stats disagree: %lld vs %u",
+          (long long)lastLatenessUs, stats.lastLatenessUs);
+    report();
+    return true;
+}
+
+// Slewing at the full rate either way, and flipping between the two
+static bool slewing() {
+    reset(1767268800LL * US_PER_S, 300);
+
+    setRate(SLEW_PPM);
+    if (!runOnTime(3600)) return false;
+    setRate(-(int32_t)SLEW_PPM);
+    if (!runOnTime(3600)) return false;
+    for (int i = 0; i < 500; i++) {
+        setRate(i % 2 ? SLEW_PPM : -(int32_t)SLEW_PPM);
+        if (!runOnTime(7)) return false;
+    }
+    report();
+    return true;
+}
+
+// A stepped clock is followed at the next firing; the tick after that is
+// on time again. Steps back within the second shown publish nothing new.
+static bool steps() {
+    reset(1767268800LL * US_PER_S, 300);
+    if (!runOnTime(10)) return false;
+
+    struct {
+        int64_t deltaUs;
+        bool jumps;
+    } cases[] = {
+        { 3600 * US_PER_S, true },
+        { -3600 * US_PER_S, true },
+        { -86400 * US_PER_S, true },
+        { -400000, false },
+        { 400000, false },
+        { 1500000, true },
+    };
+
+    for (const auto& c : cases) {
+        // Somewhere in the middle of a second
+        while (wallClock() % US_PER_S < 500000) {
+            monotonicUs += 1000;
+        }
+        step(c.deltaUs);
+        uint32_t jumpsBefore = ticker.getStats().jumps;
+        if (!fireUntilPublished()) return false;
+        CHECK(lastPublished == floorDiv(wallClock() - (int64_t)jobUs, US_PER_S),
+              "step %lld: published %lld", (long long)c.deltaUs, (long long)lastPublished);
+        CHECK((ticker.getStats().jumps != jumpsBefore) == c.jumps, "step %lld: jump not counted as expected",
+              (long long)c.deltaUs);
+        if (!runOnTime(5)) return false;
+    }
+    return true;
+}
+
+// A job overrunning a second skips the seconds it covered and then
+// settles back on the boundaries
+static bool slowJob() {
+    reset(1767268800LL * US_PER_S, 300);
+    if (!runOnTime(3)) return false;
+
+    jobUs = 1300000;
+    int64_t before = lastPublished;
+    if (!fireUntilPublished()) return false;
+    CHECK(lastPublished == before + 1, "published %lld after %lld", (long long)lastPublished, (long long)before);
+    jobUs = 20;
+    if (!fireUntilPublished()) return false;
+    CHECK(lastPublished == before + 3, "published %lld after the overrun", (long long)lastPublished);
+    return runOnTime(10);
+}
+
+int main() {
+    struct {
+        const char* name;
+        bool (*run)();
+    } scenarios[] = {
+        { "publishes at start", startsImmediately },
+        { "steady clock for a day", steadyDay },
+        { "slewing", slewing },
+        { "steps", steps },
+        { "slow job", slowJob },
+    };
+
+    for (const auto& scenario : scenarios) {
+        bool passed = scenario.run();
+        printf("%s %s\n", passed ? "PASS" : "FAIL", scenario.name);
+        failures += !passed;
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,86 @@
+"""PlatformIO pre-build script: embed web/*.html as gzipped flash arrays.
+
+Each page is minified, gzip-compressed and written to
+src/generated/web_assets.h as a const byte array (placed in flash by the
+linker) together with its length and a strong ETag derived from the
+compressed bytes. The header is only rewritten when its content changes,
+so unchanged pages do not trigger a rebuild.
+
+Can also be run directly: python3 tools/embed_web.py
+"""
+
+import gzip
+import hashlib
+import os
+import re
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO
+    PROJECT_DIR = env["PROJECT_DIR"]  # noqa: F821
+except NameError:
+    PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+WEB_DIR = os.path.join(PROJECT_DIR, "web")
+OUTPUT = os.path.join(PROJECT_DIR, "src", "generated", "web_assets.h")
+
+
+def minify(html):
+    # Conservative: trim indentation, drop blank lines and whole-line
+    # // comments. Newlines are kept so inline JS never changes meaning.
+    lines = []
+    for line in html.splitlines():
+        line = line.strip()
+        if not line or line.startswith("//"):
+            continue
+        lines.append(line)
+    text = "\n".join(lines)
+    return re.sub(r">\n<", "><", text)
+
+
+def symbol_for(filename):
+    return re.sub(r"[^A-Za-z0-9]", "_", filename).upper()
+
+
+def main():
+    pages = sorted(f for f in os.listdir(WEB_DIR) if f.endswith(".html"))
+    out = [
+        "// Generated by tools/embed_web.py from web/*.html - do not edit",
+        "#pragma once",
+        "",
+        "#include <stddef.h>",
+        "#include <stdint.h>",
+        "",
+    ]
+
+    for page in pages:
+        with open(os.path.join(WEB_DIR, page), encoding="utf-8") as f:
+            raw = f.read()
+        minified = minify(raw).encode("utf-8")
+        # mtime=0 keeps the output (and so the ETag) reproducible
+        compressed = gzip.compress(minified, compresslevel=9, mtime=0)
+        etag = hashlib.sha1(compressed).hexdigest()[:16]
+        name = symbol_for(page)
+
+        print("embed_web: %s %d -> %d (minified) -> %d bytes (gzip)"
+              % (page, len(raw.encode("utf-8")), len(minified), len(compressed)))
+
+        out.append("// %s: %d bytes raw, %d minified" % (page, len(raw.encode("utf-8")), len(minified)))
+        out.append("static const uint8_t %s_GZ[] = {" % name)
+        for i in range(0, len(compressed), 16):
+            out.append("    " + ", ".join("0x%02x" % b for b in compressed[i:i + 16]) + ",")
+        out.append("};")
+        out.append("static const size_t %s_GZ_LEN = %d;" % (name, len(compressed)))
+        out.append("#define %s_ETAG \"\\\"%s\\\"\"" % (name, etag))
+        out.append("")
+
+    content = "\n".join(out)
+    os.makedirs(os.path.dirname(OUTPUT), exist_ok=True)
+    if os.path.exists(OUTPUT):
+        with open(OUTPUT, encoding="utf-8") as f:
+            if f.read() == content:
+                return
+    with open(OUTPUT, "w", encoding="utf-8") as f:
+        f.write(content)
+
+
+main()
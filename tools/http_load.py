@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""Host-side HTTP load generator for the ledStack web server.
+
+Opens N keep-alive connections, each issuing requests back to back for a
+fixed duration, then reports requests/second and latency percentiles.
+
+    python3 tools/http_load.py --host 192.168.4.1 --connections 4 \
+        --duration 10 --path "/api/header/color?color=ff0000" --method POST
+
+With --login the workers authenticate with a session token from
+/api/login instead of Basic credentials; compare auth_token_avg_cycles and
+auth_basic_avg_cycles in /api/perf after a run of each.
+"""
+
+import argparse
+import base64
+import http.client
+import threading
+import json
+import time
+import urllib.parse
+from collections import Counter
+
+
+def login(args):
+    conn = http.client.HTTPConnection(args.host, args.port, timeout=args.timeout)
+    body = urllib.parse.urlencode({"user": args.user, "password": args.password})
+    conn.request("POST", "/api/login", body=body,
+                 headers={"Content-Type": "application/x-www-form-urlencoded"})
+    response = conn.getresponse()
+    reply = response.read()
+    conn.close()
+    if response.status != 200:
+        raise SystemExit(f"login failed: {response.status} {reply.decode(errors='replace')}")
+    return json.loads(reply)["token"]
+
+
+def worker(args, authorization, deadline, latencies, statuses, lock):
+    headers = {"Authorization": authorization, "Connection": "keep-alive"}
+    local_latencies = []
+    local_statuses = Counter()
+    conn = None
+
+    while time.monotonic() < deadline:
+        if conn is None:
+            conn = http.client.HTTPConnection(args.host, args.port, timeout=args.timeout)
+        start = time.perf_counter()
+        try:
+            conn.request(args.method, args.path, headers=headers)
+            response = conn.getresponse()
+            response.read()
+            local_statuses[response.status] += 1
+            if response.getheader("Connection", "").lower() == "close":
+                conn.close()
+                conn = None
+        except (OSError, http.client.HTTPException) as error:
+            local_statuses[type(error).__name__] += 1
+            conn.close()
+            conn = None
+            continue
+        local_latencies.append(time.perf_counter() - start)
+
+    if conn is not None:
+        conn.close()
+    with lock:
+        latencies.extend(local_latencies)
+        statuses.update(local_statuses)
+
+
+def percentile(sorted_values, fraction):
+    if not sorted_values:
+        return 0.0
+    index = min(len(sorted_values) - 1, int(fraction * len(sorted_values)))
+    return sorted_values[index]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--host", default="192.168.4.1")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--path", default="/api/perf")
+    parser.add_argument("--method", default="GET")
+    parser.add_argument("--connections", type=int, default=4)
+    parser.add_argument("--duration", type=float, default=10.0)
+    parser.add_argument("--timeout", type=float, default=5.0)
+    parser.add_argument("--user", default="ledStack")
+    parser.add_argument("--password", default="generic")
+    parser.add_argument("--login", action="store_true", help="use a session token instead of Basic auth")
+    args = parser.parse_args()
+
+    if args.login:
+        authorization = "Bearer " + login(args)
+    else:
+        authorization = "Basic " + base64.b64encode(f"{args.user}:{args.password}".encode()).decode()
+
+    latencies = []
+    statuses = Counter()
+    lock = threading.Lock()
+    deadline = time.monotonic() + args.duration
+
+    threads = [threading.Thread(target=worker, args=(args, authorization, deadline, latencies, statuses, lock))
+               for _ in range(args.connections)]
+    started = time.monotonic()
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    elapsed = time.monotonic() - started
+
+    latencies.sort()
+    print(f"{args.method} {args.path} x{args.connections} connections, {elapsed:.1f} s")
+    print(f"requests:  {len(latencies)} ({len(latencies) / elapsed:.1f} req/s)")
+    print("latency:   p50 {:.1f} ms, p90 {:.1f} ms, p99 {:.1f} ms, max {:.1f} ms".format(
+        percentile(latencies, 0.50) * 1000, percentile(latencies, 0.90) * 1000,
+        percentile(latencies, 0.99) * 1000, (latencies[-1] if latencies else 0) * 1000))
+    print("responses: " + ", ".join(f"{key}={count}" for key, count in sorted(statuses.items(), key=str)))
+
+
+if __name__ == "__main__":
+    main()
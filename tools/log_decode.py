@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+"""Decode SystemLogger binary frames (LOG_OUTPUT_BINARY) from a serial capture.
+
+Each frame is 0xA5 0x5A followed by a raw SystemLogger::Record
+(little-endian, ESP32 layout):
+
+    u64  timestampUs     esp_timer at the log() call
+    u32  format          address of the format string in the firmware
+    u8   core
+    u8   argCount
+    u8   stringMask      bit i set: args[i] is an offset into strings
+    u8   stringUsed
+    u32  args[LOG_MAX_ARGS]
+    char strings[LOG_STRING_BYTES]
+    (padded to a multiple of 8)
+
+The format address is looked up in the firmware ELF and the record is
+printed the way the text output does. Bytes outside frames (the startup
+banner and other direct Serial prints) are passed through.
+
+    python3 tools/log_decode.py .pio/build/upesy_wroom/firmware.elf capture.bin
+    pio device monitor --raw | python3 tools/log_decode.py firmware.elf -
+
+--string-bytes must match LOG_STRING_BYTES in src/Config.hpp.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+MAGIC = b"\xa5\x5a"
+MAX_ARGS = 4  # LOG_MAX_ARGS, fixed by SystemLogger::output
+
+CONVERSION = re.compile(r"%([-+ #0]*)(\d*)(?:\.(\d+))?(hh|h|ll|l|z|j|t)?([diouxXcsp%])")
+
+
+class Elf:
+    """Allocated sections of a 32-bit little-endian ELF, for string lookups."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 1 or self.data[5] != 1:
+            raise ValueError(f"{path}: not a 32-bit little-endian ELF")
+
+        shoff, = struct.unpack_from("<I", self.data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", self.data, 0x2E)
+        self.sections = []
+        for i in range(shnum):
+            _, sh_type, flags, addr, offset, size = struct.unpack_from(
+                "<IIIIII", self.data, shoff + i * shentsize)
+            # SHF_ALLOC with file contents (not SHT_NOBITS)
+            if flags & 0x2 and sh_type != 8 and size:
+                self.sections.append((addr, offset, size))
+
+    def string(self, address):
+        for addr, offset, size in self.sections:
+            if addr <= address < addr + size:
+                start = offset + address - addr
+                end = self.data.index(b"\0", start, offset + size)
+                return self.data[start:end].decode("utf-8", "replace")
+        return None
+
+
+def record_size(string_bytes):
+    size = 8 + 4 + 4 + 4 * MAX_ARGS + string_bytes
+    return (size + 7) & ~7
+
+
+def parse_record(data, string_bytes):
+    timestamp, fmt, core, count, mask, _used = struct.unpack_from("<QIBBBB", data)
+    args = list(struct.unpack_from(f"<{MAX_ARGS}I", data, 16))
+    strings = data[16 + 4 * MAX_ARGS:16 + 4 * MAX_ARGS + string_bytes]
+    for i in range(count):
+        if mask & (1 << i):
+            offset = args[i]
+            end = strings.find(b"\0", offset)
+            args[i] = strings[offset:end if end >= 0 else len(strings)].decode("utf-8", "replace")
+    return timestamp, fmt, core, args[:count]
+
+
+def format_c(fmt, args):
+    """printf with 32-bit arguments, as the firmware's snprintf would."""
+    queue = list(args)
+
+    def convert(match):
+        flags, width, precision, _length, kind = match.groups()
+        if kind == "%":
+            return "%"
+        value = queue.pop(0) if queue else 0
+        spec = "%" + flags + width + ("." + precision if precision else "")
+        if kind == "s":
+            return (spec + "s") % (value if isinstance(value, str) else f"<0x{value:08x}>")
+        if isinstance(value, str):
+            return value
+        if kind in "di":
+            value = value - (1 << 32) if value & 0x80000000 else value
+            return (spec + "d") % value
+        if kind == "c":
+            return (spec + "c") % chr(value & 0xFF)
+        if kind == "p":
+            return f"0x{value:08x}"
+        return (spec + ("d" if kind == "u" else kind)) % value
+
+    return CONVERSION.sub(convert, fmt)
+
+
+def decode(stream, elf, string_bytes, out):
+    size = record_size(string_bytes)
+    buffer = b""
+    while True:
+        # read1: return what a live serial pipe has so far
+        chunk = stream.read1(4096) if hasattr(stream, "read1") else stream.read(4096)
+        if chunk:
+            buffer += chunk
+        while True:
+            start = buffer.find(MAGIC)
+            if start < 0:
+                # Keep a trailing 0xA5 that may start the next frame
+                keep = 1 if buffer.endswith(MAGIC[:1]) else 0
+                out.write(buffer[:len(buffer) - keep].decode("utf-8", "replace"))
+                buffer = buffer[len(buffer) - keep:]
+                break
+            out.write(buffer[:start].decode("utf-8", "replace"))
+            if len(buffer) < start + 2 + size:
+                buffer = buffer[start:]
+                break
+            timestamp, fmt, core, args = parse_record(buffer[start + 2:start + 2 + size], string_bytes)
+            text = elf.string(fmt)
+            if text is None:
+                line = f"<unknown format 0x{fmt:08x}> {args}"
+            else:
+                line = format_c(text, args)
+            out.write(f"[{timestamp // 1000}.{timestamp % 1000:03d} c{core}] {line}\n")
+            buffer = buffer[start + 2 + size:]
+        if not chunk:
+            break
+    out.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("elf", help="firmware ELF the capture was logged by")
+    parser.add_argument("capture", help="raw serial capture, or - for stdin")
+    parser.add_argument("--string-bytes", type=int, default=24, help="LOG_STRING_BYTES (default 24)")
+    args = parser.parse_args()
+
+    elf = Elf(args.elf)
+    if args.capture == "-":
+        decode(sys.stdin.buffer, elf, args.string_bytes, sys.stdout)
+    else:
+        with open(args.capture, "rb") as stream:
+            decode(stream, elf, args.string_bytes, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
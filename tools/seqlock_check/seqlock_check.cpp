@@ -0,0 +1,171 @@
+// Runs the display snapshots' seqlock (src/components/SeqLock.hpp) with one
+// writer thread and several reader threads and checks that every copy a
+// reader gets is one the writer published, never a mix of two, and that
+// versions never go backwards. The point is the thread-sanitizer build:
+// it must finish without a report.
+//
+// Build and run from the repository root:
+//   g++ -std=gnu++17 -O1 -g -fsanitize=thread -pthread -Isrc/components
+//       tools/seqlock_check/seqlock_check.cpp -o seqlock_check && ./seqlock_check
+// or without the sanitizer for a longer run:
+//   g++ -std=gnu++17 -O2 -pthread -Isrc/components tools/seqlock_check/seqlock_check.cpp
+//       -o seqlock_check && ./seqlock_check 20000000
+//
+// The optional argument is the number of publishes per scenario (default
+// 200k). Prints one line per scenario and exits non-zero if any fails.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "SeqLock.hpp"
+
+static uint32_t publishCount = 200000;
+
+static int failures = 0;
+
+// Shaped like ClockDisplayState (Types.hpp): one short string
+struct ClockPayload {
+    char timeText[16];
+};
+
+// Shaped like DisplayStateSnapshot: a version, a few words and a long
+// string, with a size that is not a multiple of four
+struct StatePayload {
+    uint32_t version;
+    uint32_t headerColor;
+    uint8_t brightness;
+    char headerText[513];
+};
+
+// Every byte is derived from `n`, so a copy mixing two publishes is caught
+static void fill(ClockPayload& payload, uint32_t n) {
+    for (size_t i = 0; i < sizeof(payload.timeText) - 1; i++) {
+        payload.timeText[i] = 'A' + (n + i) % 26;
+    }
+    payload.timeText[sizeof(payload.timeText) - 1] = '\0';
+}
+
+static bool check(const ClockPayload& payload, uint32_t& n) {
+    n = (payload.timeText[0] - 'A');
+    for (size_t i = 0; i < sizeof(payload.timeText) - 1; i++) {
+        if (payload.timeText[i] != (char)('A' + (n + i) % 26)) return false;
+    }
+    return payload.timeText[sizeof(payload.timeText) - 1] == '\0';
+}
+
+static void fill(StatePayload& payload, uint32_t n) {
+    payload.version = n;
+    payload.headerColor = n * 2654435761u;
+    payload.brightness = n & 0xFF;
+    for (size_t i = 0; i < sizeof(payload.headerText) - 1; i++) {
+        payload.headerText[i] = 'a' + (n + i) % 26;
+    }
+    payload.headerText[sizeof(payload.headerText) - 1] = '\0';
+}
+
+static bool check(const StatePayload& payload, uint32_t& n) {
+    n = payload.version;
+    if (payload.headerColor != n * 2654435761u) return false;
+    if (payload.brightness != (n & 0xFF)) return false;
+    for (size_t i = 0; i < sizeof(payload.headerText) - 1; i++) {
+        if (payload.headerText[i] != (char)('a' + (n + i) % 26)) return false;
+    }
+    return payload.headerText[sizeof(payload.headerText) - 1] == '\0';
+}
+
+// The writer publishes payloads 1..count; each reader keeps reading until
+// it has seen the last one
+template <typename T>
+static bool run(uint32_t count, unsigned readerCount) {
+    SeqLock<T> lock;
+    T initial;
+    fill(initial, 0);
+    lock.publish(initial);
+    uint32_t baseVersion = lock.version();
+
+    std::atomic<bool> failed{false};
+    std::atomic<uint64_t> totalReads{0};
+
+    std::vector<std::thread> readers;
+    for (unsigned r = 0; r < readerCount; r++) {
+        readers.emplace_back([&]() {
+            uint32_t lastVersion = baseVersion;
+            uint64_t reads = 0;
+            while (!failed) {
+                T copy;
+                uint32_t version = lock.read(copy);
+                reads++;
+
+                uint32_t n;
+                if (!check(copy, n)) {
+                    printf("  torn copy at version %u\n", version);
+                    failed = true;
+                    break;
+                }
+                if (version < lastVersion) {
+                    printf("  version went from %u back to %u\n", lastVersion, version);
+                    failed = true;
+                    break;
+                }
+                // The payload published as version v is number v - baseVersion
+                if (n % 26 != (version - baseVersion) % 26) {
+                    printf("  version %u carries payload %u\n", version, n);
+                    failed = true;
+                    break;
+                }
+                lastVersion = version;
+                if (version - baseVersion == count) break;
+
+                // Give the writer the core now and then on small hosts
+                if (reads % 64 == 0) std::this_thread::yield();
+            }
+            totalReads += reads;
+        });
+    }
+
+    for (uint32_t n = 1; n <= count && !failed; n++) {
+        T payload;
+        fill(payload, n);
+        lock.publish(payload);
+        if (n % 64 == 0) std::this_thread::yield();
+    }
+
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    printf("  %u publishes, %llu reads by %u readers\n", count,
+           (unsigned long long)totalReads.load(), readerCount);
+    return !failed;
+}
+
+// The clock text: SecondTicker publishing, the display task reading
+static bool clockOneReader() { return run<ClockPayload>(publishCount, 1); }
+
+// The state snapshot: one writer (display task), the web server and
+// WebSocket clients reading
+static bool stateSeveralReaders() { return run<StatePayload>(publishCount / 4, 3); }
+
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        publishCount = strtoul(argv[1], nullptr, 10);
+    }
+
+    struct {
+        const char* name;
+        bool (*run)();
+    } scenarios[] = {
+        { "clock text, one reader", clockOneReader },
+        { "state snapshot, three readers", stateSeveralReaders },
+    };
+
+    for (const auto& scenario : scenarios) {
+        bool passed = scenario.run();
+        printf("%s %s\n", passed ? "PASS" : "FAIL", scenario.name);
+        failures += !passed;
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,172 @@
+// Runs the web->display ring (src/components/SpscRing.hpp) with a producer
+// and a consumer thread and checks that every item arrives once, in order,
+// and never half-written, while both sides spin on a full or empty ring.
+//
+// Build and run from the repository root:
+//   g++ -std=gnu++17 -O2 -pthread -Isrc/components tools/spsc_stress/spsc_stress.cpp
+//       -o spsc_stress && ./spsc_stress
+// and under the thread sanitizer (fewer items, it is much slower):
+//   g++ -std=gnu++17 -O1 -g -fsanitize=thread -pthread -Isrc/components
+//       tools/spsc_stress/spsc_stress.cpp -o spsc_stress_tsan && ./spsc_stress_tsan 1000000
+//
+// The optional argument is the number of items per scenario (default 20M).
+// Prints one line per scenario and exits non-zero if any fails.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "SpscRing.hpp"
+
+static uint64_t itemCount = 20000000;
+
+static int failures = 0;
+
+// Several words, so a torn copy shows up as a mismatch between them
+struct Item {
+    uint64_t sequence;
+    uint64_t inverse;
+    uint32_t words[4];
+};
+
+static Item makeItem(uint64_t sequence) {
+    Item item;
+    item.sequence = sequence;
+    item.inverse = ~sequence;
+    for (uint32_t i = 0; i < 4; i++) {
+        item.words[i] = (uint32_t)(sequence * 2654435761u) + i;
+    }
+    return item;
+}
+
+static bool intact(const Item& item) {
+    if (item.inverse != ~item.sequence) return false;
+    for (uint32_t i = 0; i < 4; i++) {
+        if (item.words[i] != (uint32_t)(item.sequence * 2654435761u) + i) return false;
+    }
+    return true;
+}
+
+// Spin this many times on a blocked ring before yielding. With a single
+// host core spinning only burns the other side's time, so yield at once.
+static constexpr uint32_t SPINS_BEFORE_YIELD = 64;
+static bool singleCore;
+
+static void backOff(uint64_t spins, bool yieldAtOnce) {
+    if (yieldAtOnce || singleCore || spins % SPINS_BEFORE_YIELD == 0) {
+        std::this_thread::yield();
+    }
+}
+
+// Producer pushes 0..count-1, spinning on a full ring; the consumer checks
+// each item against the next expected sequence number
+template <size_t N>
+static bool run(uint64_t count, bool yieldAtOnce) {
+    static SpscRing<Item, N> ring;
+    std::atomic<uint64_t> fullSpins{0};
+    uint64_t emptySpins = 0;
+    uint64_t maxSize = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::thread producer([&]() {
+        uint64_t spins = 0;
+        for (uint64_t sequence = 0; sequence < count; sequence++) {
+            Item item = makeItem(sequence);
+            while (!ring.push(item)) {
+                backOff(++spins, yieldAtOnce);
+            }
+        }
+        fullSpins = spins;
+    });
+
+    bool passed = true;
+    uint64_t expected = 0;
+    while (expected < count) {
+        Item item;
+        if (!ring.pop(item)) {
+            backOff(++emptySpins, yieldAtOnce);
+            continue;
+        }
+        if (!intact(item)) {
+            printf("  item %llu torn\n", (unsigned long long)expected);
+            passed = false;
+            break;
+        }
+        if (item.sequence != expected) {
+            printf("  expected %llu, got %llu\n", (unsigned long long)expected, (unsigned long long)item.sequence);
+            passed = false;
+            break;
+        }
+        expected++;
+
+        size_t size = ring.size();
+        if (size > maxSize) maxSize = size;
+    }
+
+    if (!passed) {
+        // Let the producer finish so the thread can be joined
+        Item item;
+        while (!ring.pop(item) || item.sequence + 1 < count) {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    Item leftover;
+    if (passed && ring.pop(leftover)) {
+        printf("  item %llu left after the last one\n", (unsigned long long)leftover.sequence);
+        passed = false;
+    }
+    if (maxSize > ring.capacity()) {
+        printf("  size() reported %llu, capacity %llu\n", (unsigned long long)maxSize,
+               (unsigned long long)ring.capacity());
+        passed = false;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("  %llu items in %.2f s (%.1f M/s), %llu full spins, %llu empty spins\n",
+           (unsigned long long)count, seconds, count / seconds / 1e6,
+           (unsigned long long)fullSpins.load(), (unsigned long long)emptySpins);
+    return passed;
+}
+
+// A ring this small (main.cpp's displayRing has 16 slots) blocks both
+// sides a lot
+static bool smallRing() { return run<8>(itemCount, false); }
+
+// A ring that is almost never full
+static bool largeRing() { return run<1024>(itemCount, false); }
+
+// Both sides giving up their time slice as soon as they are blocked, like
+// the display task sleeping on its notification
+static bool yielding() { return run<8>(itemCount / 10, true); }
+
+// Smallest ring: one item in flight at a time
+static bool singleSlot() { return run<2>(itemCount / 10, false); }
+
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        itemCount = strtoull(argv[1], nullptr, 10);
+    }
+    singleCore = std::thread::hardware_concurrency() < 2;
+
+    struct {
+        const char* name;
+        bool (*run)();
+    } scenarios[] = {
+        { "small ring", smallRing },
+        { "large ring", largeRing },
+        { "yielding when blocked", yielding },
+        { "single slot", singleSlot },
+    };
+
+    for (const auto& scenario : scenarios) {
+        bool passed = scenario.run();
+        printf("%s %s\n", passed ? "PASS" : "FAIL", scenario.name);
+        failures += !passed;
+    }
+    return failures ? 1 : 0;
+}
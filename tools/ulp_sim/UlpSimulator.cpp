@@ -0,0 +1,280 @@
+#include "UlpSimulator.hpp"
+#include <soc/rtc_cntl_reg.h>
+#include <soc/rtc_io_reg.h>
+#include <soc/sens_reg.h>
+#include <string.h>
+
+// RTC_FAST_CLK cycles per instruction, after the ESP32 technical reference
+// manual; close enough to estimate run time and current, not exact
+static uint32_t instructionCycles(const ulp_insn_t& insn) {
+    switch (insn.halt.opcode) {
+        case OPCODE_ALU:    return 6;
+        case OPCODE_LD:
+        case OPCODE_ST:     return 8;
+        case OPCODE_BRANCH: return 4;
+        case OPCODE_RD_REG: return 4;
+        case OPCODE_WR_REG: return 8;
+        case OPCODE_END:    return 6;
+        case OPCODE_HALT:   return 2;
+        case OPCODE_DELAY:  return 2 + insn.delay.cycles;
+        default:            return 0;
+    }
+}
+
+static unsigned periphOf(uint32_t address) {
+    return SOC_REG_TO_ULP_PERIPH_SEL(address);
+}
+
+static unsigned wordOf(uint32_t address) {
+    return (address & 0xff) / sizeof(uint32_t);
+}
+
+UlpSimulator::UlpSimulator() {
+    memset(memory, 0, sizeof(memory));
+    memset(registers, 0, sizeof(registers));
+    memset(r, 0, sizeof(r));
+    loadedSize = 0;
+    zeroFlag = false;
+    overflowFlag = false;
+    sleepSelect = 0;
+    slowCycles = 0;
+    fastRemainder = 0;
+    slowHz = 150000;
+    fastHz = 8500000;
+    latchWorks = true;
+    error = "";
+}
+
+bool UlpSimulator::fail(const char* message) {
+    error = message;
+    return false;
+}
+
+uint32_t& UlpSimulator::reg(uint32_t address) {
+    return registers[periphOf(address)][wordOf(address)];
+}
+
+void UlpSimulator::setRtcGpio(unsigned rtcGpio, bool level) {
+    uint32_t bit = 1u << (RTC_GPIO_IN_NEXT_S + rtcGpio);
+    uint32_t& in = reg(RTC_GPIO_IN_REG);
+    in = level ? (in | bit) : (in & ~bit);
+}
+
+void UlpSimulator::setSleepCycles(unsigned index, uint32_t cycles) {
+    reg(SENS_ULP_CP_SLEEP_CYC0_REG + index * sizeof(uint32_t)) = cycles;
+}
+
+void UlpSimulator::setClocks(uint32_t slow, uint32_t fast) {
+    slowHz = slow;
+    fastHz = fast;
+}
+
+bool UlpSimulator::load(const ulp_insn_t* program, size_t count) {
+    // Labels first: the address each one will have once macros are dropped
+    static constexpr size_t MAX_LABELS = 64;
+    int32_t labels[MAX_LABELS];
+    for (size_t i = 0; i < MAX_LABELS; i++) labels[i] = -1;
+
+    size_t pc = 0;
+    for (size_t i = 0; i < count; i++) {
+        const ulp_insn_t& insn = program[i];
+        if (insn.macro.opcode != OPCODE_MACRO) {
+            pc++;
+        } else if (insn.macro.sub_opcode == SUB_OPCODE_MACRO_LABEL) {
+            if (insn.macro.label >= MAX_LABELS || labels[insn.macro.label] >= 0) {
+                return fail("bad or duplicate label");
+            }
+            labels[insn.macro.label] = pc;
+        }
+    }
+    if (pc > MEMORY_WORDS) {
+        return fail("program does not fit");
+    }
+
+    // Then copy, pointing each branch after an M_BRANCH at its label
+    pc = 0;
+    int32_t pendingLabel = -1;
+    for (size_t i = 0; i < count; i++) {
+        ulp_insn_t insn = program[i];
+        if (insn.macro.opcode == OPCODE_MACRO) {
+            if (insn.macro.sub_opcode == SUB_OPCODE_MACRO_BRANCH) {
+                if (insn.macro.label >= MAX_LABELS || labels[insn.macro.label] < 0) {
+                    return fail("branch to undefined label");
+                }
+                pendingLabel = labels[insn.macro.label];
+            }
+            continue;
+        }
+
+        if (pendingLabel >= 0) {
+            if (insn.b.opcode != OPCODE_BRANCH) {
+                return fail("M_BRANCH not followed by a branch");
+            }
+            if (insn.b.sub_opcode == SUB_OPCODE_BX) {
+                insn.bx.addr = pendingLabel;
+            } else {
+                int32_t offset = pendingLabel - (int32_t)pc;
+                if (offset > 127 || offset < -127) {
+                    return fail("relative branch out of range");
+                }
+                insn.b.offset = offset < 0 ? -offset : offset;
+                insn.b.sign = offset < 0;
+            }
+            pendingLabel = -1;
+        }
+        memory[pc++] = insn.instruction;
+    }
+
+    loadedSize = pc;
+    return true;
+}
+
+void UlpSimulator::charge(uint32_t fastCycles) {
+    fastRemainder += (uint64_t)fastCycles * slowHz;
+    slowCycles += fastRemainder / fastHz;
+    fastRemainder %= fastHz;
+}
+
+void UlpSimulator::writeRegister(unsigned periph, unsigned word, unsigned low, unsigned high,
+                                 uint32_t data, Tick& result) {
+    uint32_t mask = (high - low >= 31) ? 0xFFFFFFFF : (((1u << (high - low + 1)) - 1) << low);
+    uint32_t& target = registers[periph][word];
+    target = (target & ~mask) | ((data << low) & mask);
+
+    // Setting TIME_UPDATE latches the slow counter and raises TIME_VALID
+    if (periph == periphOf(RTC_CNTL_TIME_UPDATE_REG) && word == wordOf(RTC_CNTL_TIME_UPDATE_REG) &&
+        (target & (1u << RTC_CNTL_TIME_UPDATE_S))) {
+        target &= ~(1u << RTC_CNTL_TIME_UPDATE_S);
+        target &= ~(1u << RTC_CNTL_TIME_VALID_S);
+        if (latchWorks) {
+            reg(RTC_CNTL_TIME0_REG) = (uint32_t)slowCycles;
+            reg(RTC_CNTL_TIME1_REG) = (uint32_t)(slowCycles >> 32) & 0xFFFF;
+            target |= 1u << RTC_CNTL_TIME_VALID_S;
+            result.latchedCycles = slowCycles;
+        }
+    }
+}
+
+bool UlpSimulator::tick(Tick& result) {
+    result = Tick();
+
+    // The timer counts the selected period, then starts the program at 0
+    slowCycles += registers[periphOf(SENS_ULP_CP_SLEEP_CYC0_REG)][wordOf(SENS_ULP_CP_SLEEP_CYC0_REG) + sleepSelect];
+
+    uint32_t pc = 0;
+    for (;;) {
+        if (pc >= loadedSize) {
+            return fail("program counter left the program");
+        }
+        if (++result.instructions > MAX_RUN_INSTRUCTIONS) {
+            return fail("runaway program");
+        }
+
+        ulp_insn_t insn;
+        insn.instruction = memory[pc];
+        uint32_t cycles = instructionCycles(insn);
+        result.fastCycles += cycles;
+        charge(cycles);
+        uint32_t next = pc + 1;
+
+        switch (insn.halt.opcode) {
+            case OPCODE_ALU: {
+                uint32_t a, b;
+                uint8_t dreg;
+                if (insn.alu_reg.sub_opcode == SUB_OPCODE_ALU_REG) {
+                    dreg = insn.alu_reg.dreg;
+                    a = r[insn.alu_reg.sreg];
+                    b = r[insn.alu_reg.treg];
+                } else if (insn.alu_imm.sub_opcode == SUB_OPCODE_ALU_IMM) {
+                    dreg = insn.alu_imm.dreg;
+                    a = r[insn.alu_imm.sreg];
+                    b = insn.alu_imm.imm;
+                } else {
+                    return fail("stage count instructions are not simulated");
+                }
+
+                uint32_t value;
+                overflowFlag = false;
+                switch (insn.alu_reg.sel) {
+                    case ALU_SEL_ADD: value = a + b; overflowFlag = value > 0xFFFF; break;
+                    case ALU_SEL_SUB: value = a - b; overflowFlag = a < b; break;
+                    case ALU_SEL_AND: value = a & b; break;
+                    case ALU_SEL_OR:  value = a | b; break;
+                    case ALU_SEL_MOV: value = insn.alu_reg.sub_opcode == SUB_OPCODE_ALU_REG ? a : b; break;
+                    case ALU_SEL_LSH: value = a << (b & 0x0F); break;
+                    case ALU_SEL_RSH: value = a >> (b & 0x0F); break;
+                    default: return fail("illegal ALU operation");
+                }
+                r[dreg] = value & 0xFFFF;
+                zeroFlag = r[dreg] == 0;
+                break;
+            }
+
+            case OPCODE_LD: {
+                uint32_t address = r[insn.ld.sreg] + insn.ld.offset;
+                if (address >= MEMORY_WORDS) return fail("load outside RTC slow memory");
+                r[insn.ld.dreg] = memory[address] & 0xFFFF;
+                break;
+            }
+
+            case OPCODE_ST: {
+                uint32_t address = r[insn.st.sreg] + insn.st.offset;
+                if (address >= MEMORY_WORDS) return fail("store outside RTC slow memory");
+                // The upper half-word gets the store's PC and address register
+                memory[address] = (((pc << 5) | insn.st.sreg) << 16) | r[insn.st.dreg];
+                break;
+            }
+
+            case OPCODE_BRANCH:
+                if (insn.bx.sub_opcode == SUB_OPCODE_BX) {
+                    bool taken = insn.bx.type == BX_JUMP_TYPE_DIRECT ||
+                                 (insn.bx.type == BX_JUMP_TYPE_ZERO && zeroFlag) ||
+                                 (insn.bx.type == BX_JUMP_TYPE_OVF && overflowFlag);
+                    if (taken) next = insn.bx.reg ? r[insn.bx.dreg] : insn.bx.addr;
+                } else if (insn.b.sub_opcode == SUB_OPCODE_B) {
+                    bool taken = insn.b.cmp == B_CMP_L ? r[0] < insn.b.imm : r[0] >= insn.b.imm;
+                    if (taken) next = insn.b.sign ? pc - insn.b.offset : pc + insn.b.offset;
+                } else {
+                    return fail("stage count branches are not simulated");
+                }
+                break;
+
+            case OPCODE_RD_REG: {
+                unsigned low = insn.rd_reg.low;
+                unsigned high = insn.rd_reg.high;
+                if (high < low || high - low > 15) return fail("illegal register read width");
+                uint32_t source = registers[insn.rd_reg.periph_sel][insn.rd_reg.addr % PERIPH_WORDS];
+                r[0] = (source >> low) & ((1u << (high - low + 1)) - 1);
+                break;
+            }
+
+            case OPCODE_WR_REG:
+                if (insn.wr_reg.high < insn.wr_reg.low || insn.wr_reg.high - insn.wr_reg.low > 7) {
+                    return fail("illegal register write width");
+                }
+                writeRegister(insn.wr_reg.periph_sel, insn.wr_reg.addr % PERIPH_WORDS,
+                              insn.wr_reg.low, insn.wr_reg.high, insn.wr_reg.data, result);
+                break;
+
+            case OPCODE_END:
+                if (insn.end.sub_opcode == SUB_OPCODE_END) {
+                    result.woke |= insn.end.wakeup;
+                } else {
+                    if (insn.sleep.cycle_sel > 4) return fail("illegal sleep period register");
+                    sleepSelect = insn.sleep.cycle_sel;
+                }
+                break;
+
+            case OPCODE_DELAY:
+                break;
+
+            case OPCODE_HALT:
+                result.sleepSelect = sleepSelect;
+                return true;
+
+            default:
+                return fail("illegal opcode");
+        }
+        pc = next;
+    }
+}
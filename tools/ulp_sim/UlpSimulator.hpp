@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp32/ulp.h>
+
+// Host interpreter for the ESP32 FSM ULP coprocessor.
+// Runs a ulp_insn_t program against simulated RTC slow memory and the few
+// RTC registers the timekeeper touches: the GPIO input levels, the slow
+// clock counter latch and the five sleep period registers. Each tick()
+// sleeps the selected period and then runs the program up to HALT, the way
+// the ULP timer does.
+//
+// Timing: instructions are charged RTC_FAST_CLK cycles from the ESP32
+// technical reference manual (approximate), converted to slow clock cycles
+// at the configured frequencies, so runs also advance the slow counter.
+class UlpSimulator {
+public:
+    static constexpr size_t MEMORY_WORDS = 2048;     // 8 KB RTC slow memory
+    static constexpr uint32_t MAX_RUN_INSTRUCTIONS = 4096;
+
+    struct Tick {
+        bool woke;                  // Program executed WAKE
+        uint8_t sleepSelect;        // Period register chosen for the next sleep
+        uint32_t instructions;
+        uint32_t fastCycles;
+        uint64_t latchedCycles;     // Slow counter at the last latch this run
+    };
+
+    UlpSimulator();
+
+    // Resolve labels and branches like ulp_process_macros_and_load() and
+    // place the program at word 0. Returns false (see getError()) on an
+    // unknown label, an out-of-range branch or a program that does not fit.
+    bool load(const ulp_insn_t* program, size_t count);
+    size_t getLoadedSize() const { return loadedSize; }
+
+    // Sleep, then run to HALT. Returns false on an illegal instruction,
+    // an out-of-range memory access or a runaway program.
+    bool tick(Tick& result);
+
+    const char* getError() const { return error; }
+
+    // RTC slow memory as the CPU sees it; the ULP only writes the low half
+    uint32_t& word(size_t offset) { return memory[offset]; }
+    uint16_t value(size_t offset) const { return memory[offset] & 0xFFFF; }
+
+    void setRtcGpio(unsigned rtcGpio, bool level);
+    void setSleepCycles(unsigned index, uint32_t cycles);
+
+    // Clock frequencies used to charge run time to the slow counter
+    void setClocks(uint32_t slowHz, uint32_t fastHz);
+
+    // With the latch broken RTC_CNTL_TIME_VALID never sets
+    void setLatchWorks(bool works) { latchWorks = works; }
+
+    uint64_t getSlowCycles() const { return slowCycles; }
+
+private:
+    enum { PERIPH_COUNT = 4, PERIPH_WORDS = 64 };
+
+    uint32_t memory[MEMORY_WORDS];
+    uint32_t registers[PERIPH_COUNT][PERIPH_WORDS];
+    size_t loadedSize;
+
+    uint16_t r[4];
+    bool zeroFlag;
+    bool overflowFlag;
+    uint8_t sleepSelect;
+
+    uint64_t slowCycles;
+    uint64_t fastRemainder;     // Run time not yet a whole slow cycle, scaled by slowHz
+    uint32_t slowHz;
+    uint32_t fastHz;
+    bool latchWorks;
+
+    const char* error;
+
+    uint32_t& reg(uint32_t address);
+    void writeRegister(unsigned periph, unsigned word, unsigned low, unsigned high, uint32_t data, Tick& result);
+    void charge(uint32_t fastCycles);
+    bool fail(const char* message);
+};
@@ -0,0 +1,8 @@
+#pragma once
+// Host stand-in for the ESP32 soc/rtc_cntl_reg.h: the RTC slow counter
+#include "soc.h"
+#define RTC_CNTL_TIME_UPDATE_REG (DR_REG_RTCCNTL_BASE + 0x000c)
+#define RTC_CNTL_TIME_UPDATE_S 31
+#define RTC_CNTL_TIME_VALID_S 30
+#define RTC_CNTL_TIME0_REG (DR_REG_RTCCNTL_BASE + 0x0010)
+#define RTC_CNTL_TIME1_REG (DR_REG_RTCCNTL_BASE + 0x0014)
@@ -0,0 +1,5 @@
+#pragma once
+// Host stand-in for the ESP32 soc/rtc_io_reg.h: RTC GPIO input levels
+#include "soc.h"
+#define RTC_GPIO_IN_REG (DR_REG_RTCIO_BASE + 0x0024)
+#define RTC_GPIO_IN_NEXT_S 14
@@ -0,0 +1,7 @@
+#pragma once
+// Host stand-in for the ESP32 soc/soc.h: only the RTC peripheral bases
+#define DR_REG_RTCCNTL_BASE 0x3ff48000
+#define DR_REG_RTCIO_BASE 0x3ff48400
+#define DR_REG_SENS_BASE 0x3ff48800
+#define DR_REG_RTC_I2C_BASE 0x3ff48C00
+#define DR_REG_IO_MUX_BASE 0x3ff49000
@@ -0,0 +1,351 @@
+// Runs the timekeeping ULP program (src/components/UlpProgram.cpp) on the
+// host simulator and checks its behaviour tick by tick.
+//
+// Build and run from the repository root:
+//   g++ -std=gnu++17 -O2 -Itools/ulp_sim/include -Isrc/components
+//       tools/ulp_sim/*.cpp src/components/UlpProgram.cpp
+//       src/components/Calendar.cpp -o ulp_sim && ./ulp_sim
+//
+// Prints one line per scenario and exits non-zero if any fails.
+
+#include <chrono>
+#include <stdio.h>
+#include "UlpSimulator.hpp"
+#include "UlpProgram.hpp"
+#include "Calendar.hpp"
+
+// GPIO 32 is RTC GPIO 9
+static constexpr unsigned POWER_SENSE_RTC_GPIO = 9;
+static constexpr uint16_t MAX_TICK_SECONDS = 60;
+static constexpr uint32_t SLOW_CLOCK_HZ = 150000;
+static constexpr uint32_t FAST_CLOCK_HZ = 8500000;
+
+// Where the variables live; on the device the linker places RTC_DATA_ATTR
+// data after the area reserved for the program, in no promised order, so
+// they are shuffled here
+static const UlpProgram::Variables VARIABLES = {
+    .epochLow = 519,
+    .epochHigh = 514,
+    .fracStep = 512,
+    .fracAcc = 517,
+    .ticks = 513,
+    .tickDone = 518,
+    .tickRtcLow = 516,
+    .tickRtcHigh = 515,
+};
+
+static int failures = 0;
+
+#define CHECK(condition, ...)                                   \
+    do {                                                        \
+        if (!(condition)) {                                     \
+            printf("  %s:%d: %s: ", __FILE__, __LINE__, #condition); \
+            printf(__VA_ARGS__);                                \
+            printf("\n");                                       \
+            return false;                                       \
+        }                                                       \
+    } while (0)
+
+static bool start(UlpSimulator& sim, uint16_t secondsPerTick = 1) {
+    ulp_insn_t program[UlpProgram::MAX_INSTRUCTIONS];
+    size_t size = UlpProgram::build(VARIABLES, secondsPerTick, program);
+    if (!sim.load(program, size)) {
+        printf("  load failed: %s\n", sim.getError());
+        return false;
+    }
+    sim.setClocks(SLOW_CLOCK_HZ, FAST_CLOCK_HZ);
+    sim.setSleepCycles(0, SLOW_CLOCK_HZ * secondsPerTick);
+    sim.setSleepCycles(1, SLOW_CLOCK_HZ * secondsPerTick + 1);
+    return true;
+}
+
+static void setEpoch(UlpSimulator& sim, uint32_t epoch) {
+    sim.word(VARIABLES.epochLow) = epoch & 0xFFFF;
+    sim.word(VARIABLES.epochHigh) = epoch >> 16;
+}
+
+// As TimeKeeper reads it back, masking off what ST puts in the upper halves
+static uint32_t epoch(UlpSimulator& sim) {
+    return ((uint32_t)sim.value(VARIABLES.epochHigh) << 16) | sim.value(VARIABLES.epochLow);
+}
+
+static uint32_t at(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second) {
+    Calendar::DateTime dateTime = { year, month, day, 0, hour, minute, second };
+    return Calendar::toEpoch(dateTime);
+}
+
+static bool run(UlpSimulator& sim, uint32_t ticks, UlpSimulator::Tick* last = nullptr) {
+    UlpSimulator::Tick tick;
+    for (uint32_t i = 0; i < ticks; i++) {
+        if (!sim.tick(tick)) {
+            printf("  tick %u failed: %s\n", i, sim.getError());
+            return false;
+        }
+    }
+    if (last) *last = tick;
+    return true;
+}
+
+// Ticks `ticks` times from `from` and expects the calendar to read `to`
+static bool crosses(uint32_t from, uint32_t ticks, uint32_t to, uint16_t secondsPerTick = 1) {
+    UlpSimulator sim;
+    if (!start(sim, secondsPerTick)) return false;
+
+    setEpoch(sim, from);
+    if (!run(sim, ticks)) return false;
+    Calendar::DateTime got = Calendar::fromEpoch(epoch(sim));
+    Calendar::DateTime want = Calendar::fromEpoch(to);
+    CHECK(epoch(sim) == to, "from %u: got %04u-%02u-%02u %02u:%02u:%02u, expected %04u-%02u-%02u %02u:%02u:%02u",
+          from, got.year, got.month, got.day, got.hour, got.minute, got.second,
+          want.year, want.month, want.day, want.hour, want.minute, want.second);
+    return true;
+}
+
+static bool timeOfDayRollover() {
+    return crosses(at(2026, 3, 14, 12, 0, 58), 2, at(2026, 3, 14, 12, 1, 0)) &&
+           crosses(at(2026, 3, 14, 12, 59, 59), 1, at(2026, 3, 14, 13, 0, 0)) &&
+           crosses(at(2026, 3, 14, 23, 59, 59), 1, at(2026, 3, 15, 0, 0, 0));
+}
+
+// The low half wraps every 18.2 hours; the carry into the high half runs
+// out of line and must land exactly once
+static bool lowHalfCarry() {
+    UlpSimulator sim;
+    if (!start(sim)) return false;
+
+    uint32_t start = 0x6955FFFD;
+    setEpoch(sim, start);
+    for (uint32_t i = 1; i <= 6; i++) {
+        if (!run(sim, 1)) return false;
+        CHECK(epoch(sim) == start + i, "tick %u: got 0x%08X", i, epoch(sim));
+    }
+    return crosses(0xFFFFFFFE, 1, 0xFFFFFFFF);
+}
+
+// Month, year and leap day boundaries, including 2038 where a signed 32-bit
+// time_t overflows and 2100 which is not a leap year
+static bool calendarRollover() {
+    return crosses(at(2026, 1, 31, 23, 59, 59), 1, at(2026, 2, 1, 0, 0, 0)) &&
+           crosses(at(2026, 12, 31, 23, 59, 59), 1, at(2027, 1, 1, 0, 0, 0)) &&
+           crosses(at(2027, 2, 28, 23, 59, 59), 1, at(2027, 3, 1, 0, 0, 0)) &&
+           crosses(at(2028, 2, 28, 23, 59, 59), 1, at(2028, 2, 29, 0, 0, 0)) &&
+           crosses(at(2028, 2, 29, 23, 59, 59), 1, at(2028, 3, 1, 0, 0, 0)) &&
+           crosses(at(2038, 1, 19, 3, 14, 7), 1, at(2038, 1, 19, 3, 14, 8)) &&
+           crosses(at(2100, 2, 28, 23, 59, 59), 1, at(2100, 3, 1, 0, 0, 0)) &&
+           crosses(at(2105, 12, 31, 23, 59, 59), 1, at(2106, 1, 1, 0, 0, 0));
+}
+
+// Every tick of three days against a plain counter
+static bool everySecondForThreeDays() {
+    UlpSimulator sim;
+    if (!start(sim)) return false;
+
+    uint32_t start = at(2027, 12, 30, 0, 0, 0);
+    setEpoch(sim, start);
+    for (uint32_t i = 1; i <= 3 * 86400; i++) {
+        if (!run(sim, 1)) return false;
+        CHECK(epoch(sim) == start + i, "tick %u: got %u", i, epoch(sim));
+    }
+    Calendar::DateTime date = Calendar::fromEpoch(epoch(sim));
+    CHECK(date.year == 2028 && date.month == 1 && date.day == 2 && date.weekday == 0,
+          "ended on %u-%u-%u weekday %u", date.year, date.month, date.day, date.weekday);
+    return true;
+}
+
+// Every day from 1970 to 2105 against a day-by-day counter, and a round
+// trip through toEpoch at a few times of day
+static bool calendarEveryDay() {
+    static const uint8_t DAYS_IN_MONTH[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    uint16_t year = 1970;
+    uint8_t month = 1;
+    uint8_t day = 1;
+    uint8_t weekday = 4;    // 1970-01-01 was a Thursday
+
+    for (uint32_t days = 0; year <= 2105; days++) {
+        static const uint32_t SECONDS[] = { 0, 43199, 86399 };
+        for (uint32_t second : SECONDS) {
+            uint32_t epochSeconds = days * 86400 + second;
+            Calendar::DateTime date = Calendar::fromEpoch(epochSeconds);
+            CHECK(date.year == year && date.month == month && date.day == day && date.weekday == weekday,
+                  "day %u: got %u-%u-%u", days, date.year, date.month, date.day);
+            CHECK(date.hour * 3600u + date.minute * 60u + date.second == second, "day %u second %u", days, second);
+            CHECK(Calendar::isValid(date) && Calendar::toEpoch(date) == epochSeconds, "day %u: round trip", days);
+        }
+
+        bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+        weekday = (weekday + 1) % 7;
+        if (++day > DAYS_IN_MONTH[month - 1] + (month == 2 && leap)) {
+            day = 1;
+            if (++month > 12) {
+                month = 1;
+                year++;
+            }
+        }
+    }
+
+    Calendar::DateTime bad = { 2100, 2, 29, 0, 0, 0, 0 };
+    CHECK(!Calendar::isValid(bad), "2100-02-29 accepted");
+    bad = { 2026, 4, 31, 0, 0, 0, 0 };
+    CHECK(!Calendar::isValid(bad), "2026-04-31 accepted");
+    return true;
+}
+
+// Power restore wakes the CPU through ext0; the ULP never does
+static bool neverWakes() {
+    UlpSimulator sim;
+    if (!start(sim)) return false;
+    UlpSimulator::Tick tick;
+
+    for (int i = 0; i < 10; i++) {
+        sim.setRtcGpio(POWER_SENSE_RTC_GPIO, i % 2);
+        if (!run(sim, 1, &tick)) return false;
+        CHECK(!tick.woke, "ULP woke the CPU at tick %d", i);
+    }
+    return true;
+}
+
+// Longer periods add their seconds per tick, carry included, and sleep
+// the whole period
+static bool multiSecondTicks() {
+    static const uint16_t PERIODS[] = { 2, 4, 10, 30, MAX_TICK_SECONDS };
+    for (uint16_t seconds : PERIODS) {
+        UlpSimulator sim;
+        if (!start(sim, seconds)) return false;
+        UlpSimulator::Tick tick;
+
+        uint32_t start = 0x6955FFFF - 3 * seconds;
+        setEpoch(sim, start);
+        uint64_t slowBefore = sim.getSlowCycles();
+        for (uint32_t i = 1; i <= 6; i++) {
+            if (!run(sim, 1, &tick)) return false;
+            CHECK(epoch(sim) == start + i * seconds, "%u s tick %u: got 0x%08X", seconds, i, epoch(sim));
+            CHECK(!tick.woke, "%u s tick %u woke the CPU", seconds, i);
+        }
+        uint64_t slept = sim.getSlowCycles() - slowBefore;
+        CHECK(slept >= 6ULL * seconds * SLOW_CLOCK_HZ && slept < 6ULL * seconds * SLOW_CLOCK_HZ + 100,
+              "%u s ticks slept %llu cycles", seconds, (unsigned long long)slept);
+
+        uint32_t newYear = at(2028, 1, 1, 0, 0, 0);
+        if (!crosses(newYear - seconds, 1, newYear, seconds)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The accumulator picks the N + 1 period on exactly fraction/65536 of ticks
+static bool fractionalPeriod() {
+    UlpSimulator sim;
+    if (!start(sim)) return false;
+    UlpSimulator::Tick tick;
+
+    const uint32_t fraction = 0x2A3C;
+    sim.word(VARIABLES.fracStep) = fraction;
+    uint32_t longPeriods = 0;
+    for (uint32_t i = 0; i < 65536; i++) {
+        if (!run(sim, 1, &tick)) return false;
+        longPeriods += tick.sleepSelect == 1;
+    }
+    CHECK(longPeriods == fraction, "%u long periods, expected %u", longPeriods, fraction);
+    return true;
+}
+
+// ulp_ticks and ulp_tick_done agree after every run and the stored slow
+// counter is the one latched during it; a latch that never completes must
+// not stop the clock
+static bool tickSnapshot() {
+    UlpSimulator sim;
+    if (!start(sim)) return false;
+    UlpSimulator::Tick tick;
+
+    for (uint32_t i = 1; i <= 1000; i++) {
+        if (!run(sim, 1, &tick)) return false;
+        CHECK(sim.value(VARIABLES.ticks) == (i & 0xFFFF), "ticks %u at %u", sim.value(VARIABLES.ticks), i);
+        CHECK(sim.value(VARIABLES.tickDone) == sim.value(VARIABLES.ticks), "torn snapshot at %u", i);
+        uint32_t stored = ((uint32_t)sim.value(VARIABLES.tickRtcHigh) << 16) | sim.value(VARIABLES.tickRtcLow);
+        CHECK(stored == (uint32_t)tick.latchedCycles, "stored %u, latched %u", stored, (uint32_t)tick.latchedCycles);
+    }
+
+    sim.setLatchWorks(false);
+    setEpoch(sim, 3600);
+    if (!run(sim, 5)) return false;
+    CHECK(epoch(sim) == 3600 + 5, "clock stalled by a stuck latch: %u", epoch(sim));
+    CHECK(sim.value(VARIABLES.tickDone) == sim.value(VARIABLES.ticks), "ticks not completed");
+    return true;
+}
+
+// Millions of ticks, timed, against the expected wall clock
+static bool manyTicks() {
+    UlpSimulator sim;
+    if (!start(sim)) return false;
+    UlpSimulator::Tick tick;
+
+    const uint32_t ticks = 2000000;
+    uint32_t start = at(2026, 1, 1, 0, 0, 0);
+    setEpoch(sim, start);
+    uint64_t instructions = 0;
+    uint64_t fastCycles = 0;
+
+    auto began = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < ticks; i++) {
+        if (!sim.tick(tick)) {
+            printf("  tick %u failed: %s\n", i, sim.getError());
+            return false;
+        }
+        instructions += tick.instructions;
+        fastCycles += tick.fastCycles;
+    }
+    double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - began).count();
+
+    CHECK(epoch(sim) == start + ticks, "got %u", epoch(sim));
+    printf("  %u ticks in %.0f ms; %.1f instructions and %.1f us awake per tick\n",
+           ticks, elapsedMs, (double)instructions / ticks, fastCycles * 1e6 / ticks / FAST_CLOCK_HZ);
+    return true;
+}
+
+// Two months of ticks straight through a leap day; the rollover scenarios
+// above cover the other years by jumping to them
+static bool leapFebruary() {
+    UlpSimulator sim;
+    if (!start(sim)) return false;
+
+    uint32_t start = at(2028, 2, 1, 0, 0, 0);
+    uint32_t end = at(2028, 4, 1, 0, 0, 0);
+    setEpoch(sim, start);
+    if (!run(sim, end - start)) return false;
+    Calendar::DateTime date = Calendar::fromEpoch(epoch(sim));
+    CHECK(epoch(sim) == end, "ended on %u-%u-%u %u:%u:%u", date.year, date.month, date.day,
+          date.hour, date.minute, date.second);
+    return true;
+}
+
+int main() {
+    struct {
+        const char* name;
+        bool (*run)();
+    } scenarios[] = {
+        { "time of day rollover", timeOfDayRollover },
+        { "low half carry", lowHalfCarry },
+        { "calendar rollover", calendarRollover },
+        { "every second for three days", everySecondForThreeDays },
+        { "calendar every day 1970-2105", calendarEveryDay },
+        { "ULP never wakes the CPU", neverWakes },
+        { "multi-second ticks", multiSecondTicks },
+        { "fractional period", fractionalPeriod },
+        { "tick snapshot", tickSnapshot },
+        { "two million ticks", manyTicks },
+        { "leap February", leapFebruary },
+    };
+
+    {
+        UlpSimulator sim;
+        if (start(sim)) printf("program: %zu instructions\n", sim.getLoadedSize());
+    }
+
+    for (const auto& scenario : scenarios) {
+        bool passed = scenario.run();
+        printf("%s %s\n", passed ? "PASS" : "FAIL", scenario.name);
+        failures += !passed;
+    }
+    return failures ? 1 : 0;
+}
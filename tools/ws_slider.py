@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+"""Drive the ledStack /ws control channel like a dragged slider.
+
+Sends WS_SET brightness messages at a fixed rate and times each one until
+a state push reports that value as applied. Superseded values never get
+their own push (they are coalesced on the device), so the report shows
+both latency percentiles and how many sends were merged. Panel flush time
+on top of this is in the device's /api/trace (header colour requests).
+
+So far this has only been run against a local fake WebSocket server that
+mimics the message format; it has no device latency numbers behind it.
+
+    python3 tools/ws_slider.py --host 192.168.4.1 --rate 60 --duration 10
+"""
+
+import argparse
+import base64
+import json
+import os
+import socket
+import struct
+import threading
+import time
+
+WS_SET = 1
+FIELD_BRIGHTNESS = 1
+
+
+def connect(host, port, user, password, timeout):
+    sock = socket.create_connection((host, port), timeout=timeout)
+    key = base64.b64encode(os.urandom(16)).decode()
+    auth = base64.b64encode(f"{user}:{password}".encode()).decode()
+    sock.sendall((
+        f"GET /ws HTTP/1.1\r\nHost: {host}\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+        f"Sec-WebSocket-Key: {key}\r\nSec-WebSocket-Version: 13\r\n"
+        f"Authorization: Basic {auth}\r\n\r\n").encode())
+
+    response = b""
+    while b"\r\n\r\n" not in response:
+        chunk = sock.recv(1024)
+        if not chunk:
+            raise ConnectionError("connection closed during handshake")
+        response += chunk
+    if b" 101 " not in response.split(b"\r\n", 1)[0]:
+        raise ConnectionError(response.split(b"\r\n", 1)[0].decode())
+    return sock
+
+
+def send_frame(sock, opcode, payload):
+    # Client frames are always masked
+    mask = os.urandom(4)
+    header = bytes([0x80 | opcode])
+    if len(payload) < 126:
+        header += bytes([0x80 | len(payload)])
+    else:
+        header += bytes([0x80 | 126]) + struct.pack(">H", len(payload))
+    masked = bytes(b ^ mask[i % 4] for i, b in enumerate(payload))
+    sock.sendall(header + mask + masked)
+
+
+def recv_exact(sock, length):
+    data = b""
+    while len(data) < length:
+        chunk = sock.recv(length - len(data))
+        if not chunk:
+            raise ConnectionError("connection closed")
+        data += chunk
+    return data
+
+
+def recv_frame(sock):
+    first, second = recv_exact(sock, 2)
+    length = second & 0x7F
+    if length == 126:
+        length = struct.unpack(">H", recv_exact(sock, 2))[0]
+    elif length == 127:
+        length = struct.unpack(">Q", recv_exact(sock, 8))[0]
+    return first & 0x0F, recv_exact(sock, length)
+
+
+def percentile(sorted_values, fraction):
+    if not sorted_values:
+        return 0.0
+    return sorted_values[min(len(sorted_values) - 1, int(fraction * len(sorted_values)))]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--host", default="192.168.4.1")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--rate", type=float, default=60.0, help="slider updates per second")
+    parser.add_argument("--duration", type=float, default=10.0)
+    parser.add_argument("--user", default="ledStack")
+    parser.add_argument("--password", default="generic")
+    args = parser.parse_args()
+
+    sock = connect(args.host, args.port, args.user, args.password, timeout=5)
+    sent = {}           # brightness value -> send time of its latest send
+    latencies = []
+    pushes = 0
+    lock = threading.Lock()
+    done = threading.Event()
+
+    def reader():
+        nonlocal pushes
+        sock.settimeout(1.0)
+        while not done.is_set():
+            try:
+                opcode, payload = recv_frame(sock)
+            except socket.timeout:
+                continue
+            except (OSError, ConnectionError):
+                return
+            if opcode != 0x1:
+                continue
+            now = time.perf_counter()
+            state = json.loads(payload)
+            with lock:
+                pushes += 1
+                start = sent.pop(state["brightness"], None)
+            if start is not None:
+                latencies.append(now - start)
+
+    thread = threading.Thread(target=reader, daemon=True)
+    thread.start()
+
+    interval = 1.0 / args.rate
+    count = 0
+    deadline = time.perf_counter() + args.duration
+    next_send = time.perf_counter()
+    while time.perf_counter() < deadline:
+        # Sweep 1..254 and back so consecutive values differ
+        value = 1 + (count % 508 if count % 508 < 254 else 507 - count % 508)
+        with lock:
+            sent[value] = time.perf_counter()
+        send_frame(sock, 0x2, struct.pack("<BBI", WS_SET, FIELD_BRIGHTNESS, value))
+        count += 1
+        next_send += interval
+        time.sleep(max(0.0, next_send - time.perf_counter()))
+
+    time.sleep(0.5)
+    done.set()
+    thread.join()
+    sock.close()
+
+    latencies.sort()
+    print(f"sent {count} updates at {args.rate:.0f}/s, {pushes} state pushes, "
+          f"{len(latencies)} sends observed applied ({count - len(latencies)} coalesced)")
+    print("control-to-state latency: p50 {:.1f} ms, p90 {:.1f} ms, p99 {:.1f} ms, max {:.1f} ms".format(
+        percentile(latencies, 0.50) * 1000, percentile(latencies, 0.90) * 1000,
+        percentile(latencies, 0.99) * 1000, (latencies[-1] if latencies else 0) * 1000))
+
+
+if __name__ == "__main__":
+    main()